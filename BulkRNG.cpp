@@ -0,0 +1,278 @@
+#include <cmath>
+#include <ctime>
+#include <random>
+
+#include "BulkRNG.h"
+#include "CPUDispatch.h"
+
+// Ziggurat tables (G.Marsaglia, W.W.Tsang, "The Ziggurat Method for
+// Generating Random Variables", J. Stat. Software 5 (2000))
+namespace
+{
+	struct ZigguratTables {
+		Long64_t kn[128];  // Normal: thresholds of fast path
+		Double_t wn[128];  // Normal: widths of layers / 2^31
+		Double_t fn[128];  // Normal: pdf at layer edges
+		ULong64_t ke[256]; // Exponential: thresholds of fast path
+		Double_t we[256];  // Exponential: widths of layers / 2^32
+		Double_t fe[256];  // Exponential: pdf at layer edges
+
+		ZigguratTables () {
+			const Double_t m1 = 2147483648.0, m2 = 4294967296.0;
+			Double_t dn = 3.442619855899, tn = dn, vn = 9.91256303526217e-3;
+			Double_t q = vn / exp (-0.5*dn*dn);
+			kn[0] = (dn/q) * m1;
+			kn[1] = 0;
+			wn[0] = q / m1;
+			wn[127] = dn / m1;
+			fn[0] = 1;
+			fn[127] = exp (-0.5*dn*dn);
+			for (Int_t i = 126; i >= 1; i--) {
+				dn = sqrt (-2 * log (vn/dn + exp (-0.5*dn*dn)));
+				kn[i+1] = (dn/tn) * m1;
+				tn = dn;
+				fn[i] = exp (-0.5*dn*dn);
+				wn[i] = dn / m1;
+			}
+
+			Double_t de = 7.697117470131487, te = de, ve = 3.949659822581572e-3;
+			q = ve / exp (-de);
+			ke[0] = (de/q) * m2;
+			ke[1] = 0;
+			we[0] = q / m2;
+			we[255] = de / m2;
+			fe[0] = 1;
+			fe[255] = exp (-de);
+			for (Int_t i = 254; i >= 1; i--) {
+				de = -log (ve/de + exp (-de));
+				ke[i+1] = (de/te) * m2;
+				te = de;
+				fe[i] = exp (-de);
+				we[i] = de / m2;
+			}
+		}
+	};
+	const ZigguratTables gZig;
+
+	const Double_t kNormR = 3.442619855899; // Start of normal tail
+	const Double_t kExpR  = 7.697117470131487; // Start of exponential tail
+
+	inline ULong64_t Rotl (ULong64_t x, Int_t k) {return (x << k) | (x >> (64 - k));}
+
+	inline ULong64_t SplitMix64 (ULong64_t &x) {
+		ULong64_t z = (x += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	// 53 high bits to double in (0, 1)
+	inline Double_t ToUniform (ULong64_t x) {return ((x >> 11) + 0.5) * (1.0 / 9007199254740992.0);}
+}
+
+BulkRNG::BulkRNG (UInt_t Seed) {
+	SetSeed (Seed);
+}
+
+void BulkRNG::SetSeed (UInt_t Seed) {
+	ULong64_t x = Seed;
+	if (!Seed) {
+		std::random_device rd;
+		x = ((ULong64_t) rd() << 32) ^ rd() ^ (ULong64_t) time(0);
+	}
+	for (Int_t k = 0; k < 4; k++)
+		for (Int_t l = 0; l < kLanes; l++)
+			fState[k][l] = SplitMix64 (x);
+	fUniformPos = kBufSize;
+	fGausPos    = kBufSize;
+	fExpPos     = kBufSize;
+}
+
+// xoshiro256++ step of all lanes
+inline void BulkRNG::Next (ULong64_t *Out) {
+	ULong64_t *s0 = fState[0], *s1 = fState[1], *s2 = fState[2], *s3 = fState[3];
+	for (Int_t l = 0; l < kLanes; l++) {
+		Out[l] = Rotl (s0[l] + s3[l], 23) + s0[l];
+		ULong64_t t = s1[l] << 17;
+		s2[l] ^= s0[l];
+		s3[l] ^= s1[l];
+		s1[l] ^= s2[l];
+		s0[l] ^= s3[l];
+		s2[l] ^= t;
+		s3[l] = Rotl (s3[l], 45);
+	}
+}
+
+MW_KERNEL void BulkRNG::FillRaw (ULong64_t *Out, Int_t n) {
+	Int_t i = 0;
+	for (; i + kLanes <= n; i += kLanes)
+		Next (Out + i);
+	if (i < n) {
+		ULong64_t Tail[kLanes];
+		Next (Tail);
+		for (Int_t l = 0; i < n; i++, l++)
+			Out[i] = Tail[l];
+	}
+}
+
+// Does not use fRaw: it refills buffer of Rndm called from tails of ziggurat
+MW_KERNEL void BulkRNG::FillUniform (Double_t *Out, Int_t n) {
+	ULong64_t Lanes[kLanes];
+	for (Int_t i = 0; i < n; i += kLanes) {
+		Next (Lanes);
+		for (Int_t l = 0; l < kLanes && i + l < n; l++)
+			Out[i+l] = ToUniform (Lanes[l]);
+	}
+}
+
+// Low 7 bits select layer, high 32 bits (signed) give value
+MW_KERNEL void BulkRNG::FillGaus (Double_t *Out, Int_t n, Double_t Mean, Double_t Sigma) {
+	if ((Int_t) fRaw.size() < n)
+		fRaw.resize (n);
+	ULong64_t *Raw = &fRaw[0];
+	FillRaw (Raw, n);
+	// Fast path for all draws
+	for (Int_t i = 0; i < n; i++) {
+		Int_t hz = (Int_t) (Raw[i] >> 32);
+		Out[i] = hz * gZig.wn[Raw[i] & 127];
+	}
+	// Rare rejections
+	for (Int_t i = 0; i < n; i++) {
+		Long64_t hz = (Int_t) (Raw[i] >> 32);
+		if ((hz < 0 ? -hz : hz) >= gZig.kn[Raw[i] & 127])
+			Out[i] = GausTail (Raw[i]);
+	}
+	if (Mean != 0 || Sigma != 1)
+		for (Int_t i = 0; i < n; i++)
+			Out[i] = Mean + Sigma * Out[i];
+}
+
+Double_t BulkRNG::GausTail (ULong64_t r) {
+	for (;;) {
+		Int_t hz = (Int_t) (r >> 32);
+		Int_t iz = r & 127;
+		Double_t x = hz * gZig.wn[iz];
+		if (iz == 0) {
+			// Base layer: sample from the tail beyond kNormR
+			Double_t y;
+			do {
+				x = -log (Rndm()) / kNormR;
+				y = -log (Rndm());
+			} while (y + y < x * x);
+			return hz > 0 ? kNormR + x : -kNormR - x;
+		}
+		if (gZig.fn[iz] + Rndm() * (gZig.fn[iz-1] - gZig.fn[iz]) < exp (-0.5 * x * x))
+			return x;
+		// New draw
+		ULong64_t Lanes[kLanes];
+		Next (Lanes);
+		r = Lanes[0];
+		hz = (Int_t) (r >> 32);
+		iz = r & 127;
+		Long64_t ahz = hz < 0 ? -(Long64_t) hz : hz;
+		if (ahz < gZig.kn[iz])
+			return hz * gZig.wn[iz];
+	}
+}
+
+// Low 8 bits select layer, high 32 bits give value
+MW_KERNEL void BulkRNG::FillExp (Double_t *Out, Int_t n, Double_t Tau) {
+	if ((Int_t) fRaw.size() < n)
+		fRaw.resize (n);
+	ULong64_t *Raw = &fRaw[0];
+	FillRaw (Raw, n);
+	for (Int_t i = 0; i < n; i++)
+		Out[i] = (Raw[i] >> 32) * gZig.we[Raw[i] & 255];
+	for (Int_t i = 0; i < n; i++)
+		if ((Raw[i] >> 32) >= gZig.ke[Raw[i] & 255])
+			Out[i] = ExpTail (Raw[i]);
+	if (Tau != 1)
+		for (Int_t i = 0; i < n; i++)
+			Out[i] *= Tau;
+}
+
+Double_t BulkRNG::ExpTail (ULong64_t r) {
+	for (;;) {
+		ULong64_t jz = r >> 32;
+		Int_t iz = r & 255;
+		if (iz == 0)
+			return kExpR - log (Rndm());
+		Double_t x = jz * gZig.we[iz];
+		if (gZig.fe[iz] + Rndm() * (gZig.fe[iz-1] - gZig.fe[iz]) < exp (-x))
+			return x;
+		ULong64_t Lanes[kLanes];
+		Next (Lanes);
+		r = Lanes[0];
+		jz = r >> 32;
+		iz = r & 255;
+		if (jz < gZig.ke[iz])
+			return jz * gZig.we[iz];
+	}
+}
+
+void BulkRNG::FillPoisson (Int_t *Out, Int_t n, Double_t Mean) {
+	for (Int_t i = 0; i < n; i++)
+		Out[i] = Poisson (Mean);
+}
+
+// Inversion for small mean, PTRS for large one
+// (W.Hormann, "The transformed rejection method for generating Poisson
+// random variables", Insurance: Mathematics and Economics 12 (1993))
+Int_t BulkRNG::Poisson (Double_t Mean) {
+	if (Mean <= 0)
+		return 0;
+	if (Mean < 10) {
+		Double_t p = exp (-Mean), F = p, u = Rndm();
+		Int_t k = 0;
+		while (u > F && k < 1000) {
+			k++;
+			p *= Mean / k;
+			F += p;
+		}
+		return k;
+	}
+	Double_t slam = sqrt (Mean), loglam = log (Mean);
+	Double_t b = 0.931 + 2.53 * slam;
+	Double_t a = -0.059 + 0.02483 * b;
+	Double_t invalpha = 1.1239 + 1.1328 / (b - 3.4);
+	Double_t vr = 0.9277 - 3.6224 / (b - 2);
+	for (;;) {
+		Double_t U  = Rndm() - 0.5;
+		Double_t V  = Rndm();
+		Double_t us = 0.5 - fabs (U);
+		Long64_t k  = floor ((2 * a / us + b) * U + Mean + 0.43);
+		if (us >= 0.07 && V <= vr)
+			return k;
+		if (k < 0 || (us < 0.013 && V > us))
+			continue;
+		if (log (V) + log (invalpha) - log (a / (us*us) + b) <= -Mean + k * loglam - lgamma (k + 1.))
+			return k;
+	}
+}
+
+Int_t BulkRNG::Binomial (Int_t n, Double_t p) {
+	Int_t k = 0;
+	while (n > 0) {
+		if (fUniformPos == kBufSize)
+			Refill (fUniform, fUniformPos);
+		Int_t m = kBufSize - fUniformPos;
+		if (m > n)
+			m = n;
+		const Double_t *u = fUniform + fUniformPos;
+		for (Int_t i = 0; i < m; i++)
+			k += u[i] < p;
+		fUniformPos += m;
+		n -= m;
+	}
+	return k;
+}
+
+void BulkRNG::Refill (Double_t *Buffer, Int_t &Pos) {
+	if (Buffer == fUniform)
+		FillUniform (Buffer, kBufSize);
+	else if (Buffer == fGaus)
+		FillGaus (Buffer, kBufSize);
+	else
+		FillExp (Buffer, kBufSize);
+	Pos = 0;
+}
@@ -0,0 +1,75 @@
+#ifndef BulkRNG_H
+#define BulkRNG_H
+
+#include <vector>
+
+#include <Rtypes.h>
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Random numbers generated in bulk into caller buffers.                   //
+// Generator is xoshiro256++ running in kLanes independent lanes: all      //
+// lanes are advanced by the same straight-line code, so the compiler can  //
+// keep them in SIMD registers. Distributions:                             //
+//   uniform     - 53-bit doubles in (0, 1)                                //
+//   exponential - ziggurat (256 layers)                                   //
+//   normal      - ziggurat (128 layers)                                   //
+//   Poisson     - inversion for small mean, PTRS rejection for large one  //
+// Ziggurat is done in two passes: the fast path (> 98% of draws) over the //
+// whole buffer, then rare rejected draws are replaced one by one.         //
+//                                                                         //
+// Scalar calls (Rndm, Gaus, Exp) take values from internal buffers that   //
+// are refilled in bulk. Object is not shared between threads: each        //
+// sampler (PMT, SimPhotons) owns its generator. SetSeed resets buffers.   //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+class BulkRNG
+{
+	public:
+
+		static const Int_t kLanes = 4;
+
+		BulkRNG (UInt_t Seed = 0);
+
+		void SetSeed (UInt_t Seed); // 0 - random seed
+
+	// BULK
+		void FillRaw (ULong64_t *Out, Int_t n);                      // Raw 64-bit numbers
+		void FillUniform (Double_t *Out, Int_t n);                   // Uniform in (0, 1)
+		void FillExp (Double_t *Out, Int_t n, Double_t Tau = 1);     // Exponential with mean Tau
+		void FillGaus (Double_t *Out, Int_t n, Double_t Mean = 0, Double_t Sigma = 1); // Normal
+		void FillPoisson (Int_t *Out, Int_t n, Double_t Mean);       // Poisson
+
+	// SCALAR (buffered)
+		Double_t Rndm ()   {if (fUniformPos == kBufSize) Refill (fUniform, fUniformPos); return fUniform[fUniformPos++];}
+		Double_t Gaus (Double_t Mean = 0, Double_t Sigma = 1) {
+			if (fGausPos == kBufSize) Refill (fGaus, fGausPos);
+			return Mean + Sigma * fGaus[fGausPos++];
+		}
+		Double_t Exp (Double_t Tau) {if (fExpPos == kBufSize) Refill (fExp, fExpPos); return Tau * fExp[fExpPos++];}
+		Int_t Poisson (Double_t Mean);
+		Int_t Binomial (Int_t n, Double_t p); // Counting of uniforms below p (exact, O(n))
+
+	private:
+
+		static const Int_t kBufSize = 256;
+
+		inline void Next (ULong64_t *Out); // kLanes numbers
+		void Refill (Double_t *Buffer, Int_t &Pos);
+		Double_t GausTail (ULong64_t r);   // Slow path of normal ziggurat
+		Double_t ExpTail (ULong64_t r);    // Slow path of exponential ziggurat
+
+		ULong64_t fState[4][kLanes];   // xoshiro256++ states of lanes
+		vector <ULong64_t> fRaw;       // Buffer for raw numbers
+		Double_t fUniform[kBufSize];
+		Double_t fGaus[kBufSize];
+		Double_t fExp[kBufSize];
+		Int_t fUniformPos;
+		Int_t fGausPos;
+		Int_t fExpPos;
+};
+
+#endif // BulkRNG_H
@@ -0,0 +1,13 @@
+#include "CPUDispatch.h"
+
+// The same order of preference as resolvers of target_clones
+const char* GetKernelISA () {
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__) && !defined(MW_NO_CLONES)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports ("avx512f"))
+		return "avx512f";
+	if (__builtin_cpu_supports ("avx2"))
+		return "avx2";
+#endif
+	return "default";
+}
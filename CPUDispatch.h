@@ -0,0 +1,28 @@
+#ifndef CPUDispatch_H
+#define CPUDispatch_H
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Runtime selection of instruction set for hot kernels.                   //
+//                                                                         //
+// Functions marked with MW_KERNEL (stamping of tabulated SPE, bulk random //
+// numbers, running mean and RMS of waveforms) are compiled by GCC/Clang   //
+// for AVX-512, AVX2 and baseline x86-64 in the same binary. Only loops    //
+// which vectorize are marked: loops calling virtual functions (TF1 of     //
+// PMT, TRandom) per sample or floating-point sums with branches (not      //
+// reassociated) gain nothing. Loader picks version for CPU of node once   //
+// at startup (ifunc), so one build runs the best code path on every node  //
+// of mixed fleet. GetKernelISA() reports the choice.                      //
+// Define MW_NO_CLONES to build baseline versions only.                    //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__) && !defined(MW_NO_CLONES)
+#define MW_KERNEL __attribute__((target_clones("avx512f","avx2","default")))
+#else
+#define MW_KERNEL
+#endif
+
+const char* GetKernelISA (); // Version of kernels running on this CPU ("avx512f", "avx2" or "default")
+
+#endif // CPUDispatch_H
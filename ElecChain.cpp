@@ -0,0 +1,150 @@
+#include <iostream>
+#include <cmath>
+
+#include "ElecChain.h"
+
+using std::cout;
+using std::endl;
+
+ElecChain::ElecChain (UInt_t Seed) {
+	fRND.SetSeed(Seed);
+	fScratch.resize (1);
+}
+
+// Buffers are only added, so threads started before with fewer threads are not affected
+void ElecChain::SetNumThreads (Int_t NumThreads) {
+	if (NumThreads > (Int_t) fScratch.size())
+		fScratch.resize (NumThreads);
+}
+
+void ElecChain::AddStage (StageType Type, Double_t p0, Double_t p1, Double_t p2, Double_t p3, Double_t p4) {
+	Stage st;
+	st.fType   = Type;
+	st.fPar[0] = p0;
+	st.fPar[1] = p1;
+	st.fPar[2] = p2;
+	st.fPar[3] = p3;
+	st.fPar[4] = p4;
+	st.fBank   = 0;
+	fStages.push_back (st);
+}
+
+void ElecChain::AddGain (Double_t Gain)                      {AddStage (kGain, Gain);}
+void ElecChain::AddOffset (Double_t Offset)                  {AddStage (kOffset, Offset);}
+void ElecChain::AddWhiteNoise (Double_t Sigma)               {AddStage (kWhiteNoise, Sigma);}
+void ElecChain::AddColoredNoise (Double_t Sigma, Double_t Tau) {AddStage (kColoredNoise, Sigma, Tau);}
+void ElecChain::AddLowPass (Double_t Tau)                    {AddStage (kLowPass, Tau);}
+void ElecChain::AddIIR (Double_t b0, Double_t b1, Double_t b2, Double_t a1, Double_t a2) {AddStage (kIIR, b0, b1, b2, a1, a2);}
+void ElecChain::AddClip (Double_t Min, Double_t Max)         {AddStage (kClip, Min, Max);}
+void ElecChain::AddRound ()                                  {AddStage (kRound);}
+
+// Period is checked here once, not on every Apply
+Bool_t ElecChain::AddBankNoise (NoiseBank *Bank, Double_t Period) {
+	if (!Bank || fabs (Bank->GetPeriod() - Period) > 1e-6 * Period) {
+		if (Bank)
+			cout << "ERROR. Noise bank was generated for period " << Bank->GetPeriod()/ns << " ns, not " << Period/ns << " ns" << endl;
+		return false;
+	}
+	AddStage (kBankNoise);
+	fStages.back().fBank = Bank;
+	return true;
+}
+
+void ElecChain::Apply (Double_t *Wave, Int_t NumSamples, Double_t Period, TRandom *RND, Int_t Thread) {
+	if (!RND)
+		RND = &fRND;
+	const Int_t NumStages = fStages.size();
+	if (!NumStages)
+		return;
+	if (Thread < 0 || Thread >= (Int_t) fScratch.size()) {
+		cout << "ERROR. Electronics chain is set for " << fScratch.size() << " threads, called from thread " << Thread << endl;
+		return;
+	}
+
+	// Coefficients for this sampling period and states of stages
+	Scratch &Buf = fScratch[Thread];
+	Buf.c.assign  (NumStages, 0);
+	Buf.c2.assign (NumStages, 0);
+	Buf.s1.assign (NumStages, 0);
+	Buf.s2.assign (NumStages, 0);
+	Buf.Bank.assign (NumStages, (const Float_t*) 0);
+	Buf.BankPos.assign  (NumStages, 0);
+	Buf.BankSize.assign (NumStages, 0);
+	Double_t *c  = &Buf.c[0];
+	Double_t *c2 = &Buf.c2[0];
+	Double_t *s1 = &Buf.s1[0];
+	Double_t *s2 = &Buf.s2[0];
+	const Float_t **Bank = &Buf.Bank[0];
+	Int_t *BankPos  = &Buf.BankPos[0];
+	Int_t *BankSize = &Buf.BankSize[0];
+	for (Int_t k = 0; k < NumStages; k++) {
+		const Stage &st = fStages[k];
+		switch (st.fType) {
+			case kColoredNoise:
+				c[k]  = exp (-Period / st.fPar[1]);
+				c2[k] = st.fPar[0] * sqrt (1 - c[k]*c[k]);
+				s1[k] = st.fPar[0] * RND->Gaus(); // Start in stationary state
+				break;
+			case kLowPass:
+				c[k]  = 1 - exp (-Period / st.fPar[0]);
+				break;
+			case kBankNoise:
+				Bank[k]     = st.fBank->GetData();
+				BankSize[k] = st.fBank->GetSize();
+				BankPos[k]  = st.fBank->GetRandomOffset (RND);
+				break;
+			default:
+				break;
+		}
+	}
+
+	// One pass: each sample goes through all stages
+	const Stage *Stages = &fStages[0];
+	for (Int_t i = 0; i < NumSamples; i++) {
+		Double_t x = Wave[i];
+		for (Int_t k = 0; k < NumStages; k++) {
+			const Double_t *p = Stages[k].fPar;
+			switch (Stages[k].fType) {
+				case kGain:
+					x *= p[0];
+					break;
+				case kOffset:
+					x += p[0];
+					break;
+				case kWhiteNoise:
+					x += p[0] * RND->Gaus();
+					break;
+				case kColoredNoise:
+					s1[k] = c[k] * s1[k] + c2[k] * RND->Gaus();
+					x += s1[k];
+					break;
+				case kBankNoise:
+					if (Bank[k]) {
+						x += Bank[k][BankPos[k]];
+						if (++BankPos[k] == BankSize[k])
+							BankPos[k] = 0;
+					}
+					break;
+				case kLowPass:
+					s1[k] += c[k] * (x - s1[k]);
+					x = s1[k];
+					break;
+				case kIIR: {
+					// Direct form II transposed
+					Double_t y = p[0] * x + s1[k];
+					s1[k] = p[1] * x - p[3] * y + s2[k];
+					s2[k] = p[2] * x - p[4] * y;
+					x = y;
+					break;
+				}
+				case kClip:
+					x = x < p[0] ? p[0] : (x > p[1] ? p[1] : x);
+					break;
+				case kRound:
+					x = floor (x + 0.5);
+					break;
+			}
+		}
+		Wave[i] = x;
+	}
+}
@@ -0,0 +1,101 @@
+#ifndef ElecChain_H
+#define ElecChain_H
+
+#include <vector>
+
+#include <Rtypes.h>
+#include <TRandom3.h>
+#include "SystemOfUnits.h"
+
+#include "NoiseBank.h"
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Response of read-out electronics applied to rendered waveform (in ADC   //
+// units): chain of stages executed in the order they were added.          //
+// Stages: amplifier gain, shaping filter (RC low-pass or any biquad IIR), //
+// baseline offset, white (Gaussian) noise, colored noise (AR(1) process   //
+// with correlation time Tau), noise from NoiseBank (random window of bank //
+// with measured PSD), clipping to ADC range and rounding to ADC counts.   //
+//                                                                         //
+// All stages are executed in one pass over waveform: each sample goes     //
+// through the whole chain while it is in register, so the chain costs     //
+// one read and one write of waveform regardless of number of stages.      //
+// Filter states start from zero in each waveform, colored noise starts    //
+// in its stationary state. Working buffers are kept between calls, one    //
+// set per thread (see SetNumThreads), so Apply doesn't allocate memory.   //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+using CLHEP::ns;
+
+class ElecChain
+{
+	public:
+
+		ElecChain (UInt_t Seed = 4357); // Seed of own generator (MakeWave::SetSeed reseeds it for each event)
+
+	// SETTERS (each call adds stage to the end of chain)
+		void AddGain (Double_t Gain);                 // Multiply by amplifier gain
+		void AddOffset (Double_t Offset);             // Add baseline (ADC units)
+		void AddWhiteNoise (Double_t Sigma);          // Add Gaussian noise (ADC units)
+		void AddColoredNoise (Double_t Sigma, Double_t Tau); // Add AR(1) noise with RMS Sigma and correlation time Tau
+		Bool_t AddBankNoise (NoiseBank *Bank, Double_t Period); // Add noise from bank generated for sampling Period of waves (false if bank's period differs)
+		void AddLowPass (Double_t Tau);               // RC shaping with time constant Tau
+		void AddIIR (Double_t b0, Double_t b1, Double_t b2, Double_t a1, Double_t a2); // Biquad y = b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2
+		void AddClip (Double_t Min, Double_t Max);    // Limit to ADC range
+		void AddRound ();                             // Round to ADC counts
+		void Clear () {fStages.clear();}
+		void SetSeed (UInt_t Seed) {fRND.SetSeed(Seed);}
+		void SetNumThreads (Int_t NumThreads); // Number of threads calling Apply concurrently (call before starting them)
+
+	// GETTERS
+		Int_t GetNumStages () {return fStages.size();}
+
+	// ACTIONS
+		// Apply chain to waveform with sampling Period (RND - generator for noise, 0 - own one),
+		// Thread - index of calling thread (0 .. NumThreads-1)
+		void Apply (Double_t *Wave, Int_t NumSamples, Double_t Period, TRandom *RND = 0, Int_t Thread = 0);
+		void Apply (vector <double> &Wave, Double_t Period, TRandom *RND = 0, Int_t Thread = 0) {
+			if (Wave.size()) Apply (&Wave[0], Wave.size(), Period, RND, Thread);
+		}
+
+	private:
+
+		enum StageType {
+			kGain,
+			kOffset,
+			kWhiteNoise,
+			kColoredNoise,
+			kBankNoise,
+			kLowPass,
+			kIIR,
+			kClip,
+			kRound
+		};
+
+		struct Stage {
+			StageType fType;
+			Double_t fPar[5]; // Parameters of stage
+			NoiseBank *fBank; // Bank for kBankNoise
+		};
+		vector <Stage> fStages;
+		TRandom3 fRND;
+
+		// Coefficients for sampling period and states of stages
+		struct Scratch {
+			vector <Double_t> c;        // Coefficient
+			vector <Double_t> c2;       // Second coefficient
+			vector <Double_t> s1;       // State
+			vector <Double_t> s2;       // Second state
+			vector <const Float_t*> Bank; // Noise bank
+			vector <Int_t> BankPos;     // Position in bank
+			vector <Int_t> BankSize;
+		};
+		vector <Scratch> fScratch;    // For each thread
+
+		void AddStage (StageType Type, Double_t p0 = 0, Double_t p1 = 0, Double_t p2 = 0, Double_t p3 = 0, Double_t p4 = 0);
+};
+
+#endif // ElecChain_H
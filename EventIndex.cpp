@@ -0,0 +1,104 @@
+#include <iostream>
+#include <cstring>
+
+#include "EventIndex.h"
+
+using std::cout;
+using std::endl;
+
+static const char kIndexMagic[8] = {'M','W','I','N','D','X','0','1'};
+
+Bool_t EventIndexCut::Pass (const EventIndexRecord &Rec) const {
+	if (fWrittenOnly && Rec.fEntry == EventIndexRecord::kRejected)
+		return false;
+	return Rec.fNumPhotons >= fMinPhotons && Rec.fNumPhotons <= fMaxPhotons &&
+	       Rec.fNumPE >= fMinPE && Rec.fNumPE <= fMaxPE &&
+	       Rec.fF90 >= fMinF90 && Rec.fF90 <= fMaxF90;
+}
+
+// WRITER
+
+EventIndexWriter::EventIndexWriter () {
+	fFile = 0;
+}
+
+EventIndexWriter::~EventIndexWriter () {
+	Close();
+}
+
+Bool_t EventIndexWriter::Open (const char *filename, Double_t FracTime, Double_t WindowBegin, Double_t WindowEnd) {
+	Close();
+	fFile = fopen (filename, "wb");
+	if (!fFile) {
+		cout << "ERROR. File " << filename << " can't be written" << endl;
+		return false;
+	}
+	memset (&fHeader, 0, sizeof(fHeader));
+	memcpy (fHeader.fMagic, kIndexMagic, sizeof(kIndexMagic));
+	fHeader.fFracTime    = FracTime;
+	fHeader.fWindowBegin = WindowBegin;
+	fHeader.fWindowEnd   = WindowEnd;
+	return fwrite (&fHeader, sizeof(fHeader), 1, fFile) == 1;
+}
+
+Bool_t EventIndexWriter::AddEvent (const EventIndexRecord &Rec) {
+	if (!fFile) {
+		cout << "ERROR. Index file was not created" << endl;
+		return false;
+	}
+	if (fwrite (&Rec, sizeof(Rec), 1, fFile) != 1) {
+		cout << "ERROR. Index file can't be written" << endl;
+		return false;
+	}
+	fHeader.fNumEvents++;
+	return true;
+}
+
+Bool_t EventIndexWriter::Close () {
+	if (!fFile)
+		return false;
+	Bool_t ok = !fseek (fFile, 0, SEEK_SET) && fwrite (&fHeader, sizeof(fHeader), 1, fFile) == 1;
+	ok = !fclose (fFile) && ok;
+	fFile = 0;
+	return ok;
+}
+
+// READER
+
+Bool_t EventIndexReader::Open (const char *filename) {
+	fRecords.clear();
+	FILE *file = fopen (filename, "rb");
+	if (!file) {
+		cout << "ERROR. File " << filename << " can't be read" << endl;
+		return false;
+	}
+	Bool_t ok = fread (&fHeader, sizeof(fHeader), 1, file) == 1 && !memcmp (fHeader.fMagic, kIndexMagic, sizeof(kIndexMagic));
+	if (ok) {
+		fRecords.resize (fHeader.fNumEvents);
+		ok = !fHeader.fNumEvents || fread (&fRecords[0], sizeof(EventIndexRecord), fRecords.size(), file) == fRecords.size();
+	}
+	fclose (file);
+	if (!ok) {
+		cout << "ERROR. File " << filename << " is not an event index" << endl;
+		fRecords.clear();
+	}
+	return ok;
+}
+
+vector <EventIndexRecord> EventIndexReader::Select (const EventIndexCut &Cut) {
+	vector <EventIndexRecord> Selected;
+	for (unsigned int i = 0; i < fRecords.size(); i++) {
+		if (Cut.Pass (fRecords[i]))
+			Selected.push_back (fRecords[i]);
+	}
+	return Selected;
+}
+
+vector <Long64_t> EventIndexReader::SelectEntries (const EventIndexCut &Cut) {
+	vector <Long64_t> Entries;
+	for (unsigned int i = 0; i < fRecords.size(); i++) {
+		if (fRecords[i].fEntry >= 0 && Cut.Pass (fRecords[i])) // Only events present in output files
+			Entries.push_back (fRecords[i].fEntry);
+	}
+	return Entries;
+}
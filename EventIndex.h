@@ -0,0 +1,101 @@
+#ifndef EventIndex_H
+#define EventIndex_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#include <Rtypes.h>
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Index of generated run, written alongside its output file (name.idx).   //
+// For each event it keeps the entry of event in output files (REDFile,    //
+// pulse file and flat file have the same entries), its number in run,     //
+// seed, number of photons, NumPE and F90, so events may be selected       //
+// without reading output files and then read directly by entry.           //
+//                                                                         //
+// File consists of EventIndexHeader (window of photon simulation and      //
+// F90 window of the run) followed by EventIndexRecord of each event.      //
+// Header is rewritten by Close(). Events rejected by trigger have entry   //
+// -1 (they are kept since seed allows to regenerate them), events of run  //
+// without output files (seeds only) have entry -2.                        //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+struct EventIndexHeader {
+	char      fMagic[8];        // "MWINDX01"
+	ULong64_t fNumEvents;
+	Double_t  fFracTime;        // Window for F90
+	Double_t  fWindowBegin;     // Window of photon simulation (Begin == End - all photons)
+	Double_t  fWindowEnd;
+};
+
+struct EventIndexRecord {
+	enum {
+		kRejected   = -1,       // Entry of event rejected by trigger
+		kNotWritten = -2        // Entry of event not written (seeds only, see RunRegenerator)
+	};
+	Long64_t  fEntry;           // Entry in output files (kRejected, kNotWritten)
+	Long64_t  fEventID;         // Number of event in run
+	ULong64_t fSeed;            // Seed of event
+	Int_t     fNumPhotons;      // Requested number of photons (before window of simulation)
+	Int_t     fNumPE;
+	Double_t  fF90;
+};
+
+// Selection of events (ranges are inclusive)
+struct EventIndexCut {
+	Int_t    fMinPhotons, fMaxPhotons;
+	Int_t    fMinPE,      fMaxPE;
+	Double_t fMinF90,     fMaxF90;
+	Bool_t   fWrittenOnly;      // Skip events rejected by trigger (not written events pass)
+
+	EventIndexCut () : fMinPhotons(0), fMaxPhotons(kMaxInt), fMinPE(0), fMaxPE(kMaxInt),
+	                   fMinF90(-1), fMaxF90(2), fWrittenOnly(true) {}
+	Bool_t Pass (const EventIndexRecord &Rec) const;
+};
+
+class EventIndexWriter
+{
+	public:
+
+		EventIndexWriter ();
+		~EventIndexWriter ();
+
+		Bool_t Open (const char *filename, Double_t FracTime, Double_t WindowBegin = 0, Double_t WindowEnd = 0);
+		Bool_t AddEvent (const EventIndexRecord &Rec);
+		Bool_t Close (); // Write header and close file
+		Bool_t IsOpen () {return fFile != 0;}
+
+		static std::string GetIndexName (const std::string &OutName) {return OutName + ".idx";} // Index of output file
+
+	private:
+
+		FILE *fFile;
+		EventIndexHeader fHeader;
+};
+
+class EventIndexReader
+{
+	public:
+
+		EventIndexReader () {}
+
+		Bool_t Open (const char *filename); // Read whole index (records are small)
+
+		const EventIndexHeader& GetHeader () {return fHeader;}
+		Long64_t GetNumEvents () {return fRecords.size();}
+		const EventIndexRecord& GetRecord (Long64_t i) {return fRecords[i];}
+		vector <EventIndexRecord> Select (const EventIndexCut &Cut);   // Records of events passing cut
+		vector <Long64_t> SelectEntries (const EventIndexCut &Cut);    // Their entries in output files (rejected and not written events are skipped)
+
+	private:
+
+		EventIndexHeader fHeader;
+		vector <EventIndexRecord> fRecords;
+};
+
+#endif // EventIndex_H
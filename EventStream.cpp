@@ -0,0 +1,54 @@
+#include <iostream>
+
+#include "EventStream.h"
+
+using std::cout;
+using std::endl;
+
+EventStream::EventStream (WaveGenerator *Gen, const char *type, Long64_t FirstEvent, Long64_t NumEvents) {
+	fGen          = Gen;
+	fType         = type;
+	fEventID      = FirstEvent;
+	fLastEvent    = FirstEvent;
+	fMaxPassed    = -1;
+	fNumSimulated = 0;
+	fNumPassed    = 0;
+	const RunConfig *Config = fGen->GetConfig();
+	if (!Config) {
+		cout << "ERROR. Generator was not created from run config" << endl;
+		return;
+	}
+	fLastEvent = NumEvents < 0 ? Config->GetNumEvents() : FirstEvent + NumEvents;
+	if (fLastEvent > Config->GetNumEvents())
+		fLastEvent = Config->GetNumEvents();
+}
+
+EventStream& EventStream::Filter (Predicate Pass) {
+	fFilters.push_back (Pass);
+	return *this;
+}
+
+EventStream& EventStream::Take (Long64_t Num) {
+	fMaxPassed = fNumPassed + Num;
+	return *this;
+}
+
+// Events are simulated until one passes all filters
+const MWEvent* EventStream::Next () {
+	while (fEventID < fLastEvent && (fMaxPassed < 0 || fNumPassed < fMaxPassed)) {
+		if (!fGen->SimulateEvent (fType.c_str(), fEventID++)) {
+			fLastEvent = fEventID;
+			return 0;
+		}
+		fNumSimulated++;
+		const MWEvent &Event = fGen->GetEvent();
+		Bool_t Pass = true;
+		for (unsigned int i = 0; Pass && i < fFilters.size(); i++)
+			Pass = fFilters[i] (Event);
+		if (Pass) {
+			fNumPassed++;
+			return &Event;
+		}
+	}
+	return 0;
+}
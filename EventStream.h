@@ -0,0 +1,79 @@
+#ifndef EventStream_H
+#define EventStream_H
+
+#include <vector>
+#include <string>
+#include <functional>
+
+#include <Rtypes.h>
+
+#include "MakeWaveAPI.h"
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Pull-based stream of events of run config.                              //
+//                                                                         //
+// Event is simulated only when it is pulled by Next() (or by iterating    //
+// the stream in range-for). Filters are applied to each event in the      //
+// order they were added, events which fail are dropped and the next one   //
+// is simulated; Take(n) ends stream after n events passed. Stream gives   //
+// MWEvent of WaveGenerator (views into MakeWave, valid until the next     //
+// event), so no event is stored. E.g. the first 100 ER events with F90    //
+// above 0.5:                                                              //
+//   EventStream Events (&Gen, "ER");                                      //
+//   Events.Filter ([] (const MWEvent &E) {return E.fF90 > 0.5;});         //
+//   for (const MWEvent &Event : Events.Take (100)) {...}                  //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+class EventStream
+{
+	public:
+
+		typedef std::function <Bool_t (const MWEvent &Event)> Predicate;
+
+		// Events FirstEvent, FirstEvent+1, ... of type (NumEvents = -1 - up to the end of run)
+		EventStream (WaveGenerator *Gen, const char *type, Long64_t FirstEvent = 0, Long64_t NumEvents = -1);
+
+	// SETTERS
+		EventStream& Filter (Predicate Pass); // Keep only events passing Pass (filters are combined)
+		EventStream& Take (Long64_t Num);     // End stream after Num events
+
+	// GETTERS
+		Long64_t GetNumSimulated () {return fNumSimulated;} // Events simulated so far (passed or not)
+		Long64_t GetNumPassed ()    {return fNumPassed;}
+
+	// ACTIONS
+		const MWEvent* Next (); // Next event passing all filters (0 - end of stream)
+
+		// Input iterator over remaining events
+		class Iterator
+		{
+			public:
+				Iterator (EventStream *Stream, const MWEvent *Event) : fStream (Stream), fEvent (Event) { ; }
+				const MWEvent& operator* () const {return *fEvent;}
+				const MWEvent* operator-> () const {return fEvent;}
+				Iterator& operator++ () {fEvent = fStream->Next(); return *this;}
+				bool operator!= (const Iterator &Other) const {return fEvent != Other.fEvent;}
+			private:
+				EventStream *fStream;
+				const MWEvent *fEvent;
+		};
+		Iterator begin () {return Iterator (this, Next());}
+		Iterator end ()   {return Iterator (this, 0);}
+
+	private:
+
+		WaveGenerator *fGen;
+		std::string fType;
+		Long64_t fEventID;      // Next event to simulate
+		Long64_t fLastEvent;    // End of events range
+		Long64_t fMaxPassed;    // Limit of Take (-1 - none)
+		Long64_t fNumSimulated;
+		Long64_t fNumPassed;
+		vector <Predicate> fFilters;
+};
+
+#endif // EventStream_H
@@ -0,0 +1,245 @@
+#include <iostream>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "FlatWaveFile.h"
+#include "WaveCodec.h"
+
+using std::cout;
+using std::endl;
+
+static const char kFileMagic[8] = {'M','W','F','L','A','T','0','2'};
+static const char kWaveMagic[4] = {'M','W','W','F'};
+
+// Size rounded up to whole pages
+static ULong64_t PageRound (ULong64_t size) {
+	return (size + kFlatPageSize - 1) / kFlatPageSize * kFlatPageSize;
+}
+
+// Size of one sample (for not coded samples)
+static size_t SampleSize (Int_t SampleType) {
+	return SampleType == kFlatInt16 ? sizeof(Short_t) : sizeof(Double_t);
+}
+
+Bool_t FlatWaveView::Decode (vector <double> &Samples) const {
+	if (fSampleType == kFlatCodec)
+		return WaveCodec::Decode (GetCoded(), GetDataSize(), Samples);
+	Samples.resize (GetNumSamples());
+	for (Int_t i = 0; i < GetNumSamples(); i++)
+		Samples[i] = At(i);
+	return true;
+}
+
+// WRITER
+
+FlatWaveWriter::FlatWaveWriter () {
+	fFD = -1;
+}
+
+FlatWaveWriter::~FlatWaveWriter () {
+	Close();
+}
+
+Bool_t FlatWaveWriter::WriteAt (const void *data, size_t size, ULong64_t offset) {
+	const char *ptr = (const char*) data;
+	while (size) {
+		ssize_t written = pwrite (fFD, ptr, size, offset);
+		if (written <= 0) {
+			cout << "ERROR. Flat file can't be written" << endl;
+			return false;
+		}
+		ptr    += written;
+		size   -= written;
+		offset += written;
+	}
+	return true;
+}
+
+Bool_t FlatWaveWriter::Open (const char *filename, Int_t SampleType) {
+	Close();
+	fFD = open (filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fFD < 0) {
+		cout << "ERROR. File " << filename << " can't be written" << endl;
+		return false;
+	}
+	fSampleType = SampleType;
+	fIndex.clear();
+
+	vector <char> page (kFlatPageSize, 0);
+	FlatFileHeader *header = (FlatFileHeader*) &page[0];
+	memcpy (header->fMagic, kFileMagic, sizeof(kFileMagic));
+	header->fPageSize     = kFlatPageSize;
+	header->fSampleType   = fSampleType;
+	header->fNumWaveforms = 0;
+	header->fIndexOffset  = 0;
+	fEnd = kFlatPageSize;
+	if (!WriteAt (&page[0], kFlatPageSize, 0)) {
+		close (fFD);
+		fFD = -1;
+		return false;
+	}
+	return true;
+}
+
+Bool_t FlatWaveWriter::AddWaveform (Long64_t EventID, Int_t Channel, const Double_t *Samples, Int_t NumSamples,
+                                    Double_t Period, Double_t Gain, Double_t Delay) {
+	if (fFD < 0) {
+		cout << "ERROR. Flat file was not created" << endl;
+		return false;
+	}
+	if (NumSamples < 0 || (NumSamples && !Samples)) {
+		cout << "ERROR. Wrong waveform of event " << EventID << " for flat file" << endl;
+		return false;
+	}
+	// Fill record: header and samples padded to whole pages
+	size_t DataSize = NumSamples * SampleSize (fSampleType);
+	if (fSampleType == kFlatCodec)
+		DataSize = WaveCodec::Encode (Samples, NumSamples, fCoded);
+	ULong64_t RecordSize = PageRound (sizeof(FlatWaveHeader) + DataSize);
+	fBuffer.assign (RecordSize, 0);
+	FlatWaveHeader *header = (FlatWaveHeader*) &fBuffer[0];
+	memcpy (header->fMagic, kWaveMagic, sizeof(kWaveMagic));
+	header->fChannel    = Channel;
+	header->fEventID    = EventID;
+	header->fNumSamples = NumSamples;
+	header->fDataSize   = DataSize;
+	header->fPeriod     = Period;
+	header->fGain       = Gain;
+	header->fDelay      = Delay;
+	char *data = &fBuffer[sizeof(FlatWaveHeader)];
+	if (fSampleType == kFlatInt16) {
+		Short_t *out = (Short_t*) data;
+		for (Int_t i = 0; i < NumSamples; i++) {
+			Double_t value = round (Samples[i]);
+			if (value >  32767) value =  32767;
+			if (value < -32768) value = -32768;
+			out[i] = value;
+		}
+	}
+	else if (DataSize)
+		memcpy (data, fSampleType == kFlatCodec ? (const void*) &fCoded[0] : (const void*) Samples, DataSize);
+
+	// Write record, then publish it for readers
+	if (!WriteAt (&fBuffer[0], RecordSize, fEnd))
+		return false;
+	fIndex.push_back (fEnd);
+	fEnd += RecordSize;
+	ULong64_t NumWaveforms = fIndex.size();
+	return WriteAt (&NumWaveforms, sizeof(NumWaveforms), offsetof(FlatFileHeader, fNumWaveforms));
+}
+
+void FlatWaveWriter::Close () {
+	if (fFD < 0)
+		return;
+	// Index at the end of file
+	ULong64_t IndexOffset = fEnd;
+	if (fIndex.size())
+		WriteAt (&fIndex[0], fIndex.size() * sizeof(ULong64_t), IndexOffset);
+	WriteAt (&IndexOffset, sizeof(IndexOffset), offsetof(FlatFileHeader, fIndexOffset));
+	close (fFD);
+	fFD = -1;
+}
+
+// READER
+
+FlatWaveReader::FlatWaveReader () {
+	fFD      = -1;
+	fMap     = 0;
+	fMapSize = 0;
+}
+
+FlatWaveReader::~FlatWaveReader () {
+	Close();
+}
+
+Bool_t FlatWaveReader::Open (const char *filename) {
+	Close();
+	fFD = open (filename, O_RDONLY);
+	if (fFD < 0) {
+		cout << "ERROR. File " << filename << " can't be read" << endl;
+		return false;
+	}
+	FlatFileHeader header;
+	if (pread (fFD, &header, sizeof(header), 0) != sizeof(header) ||
+	    memcmp (header.fMagic, kFileMagic, sizeof(kFileMagic)) || header.fPageSize != kFlatPageSize) {
+		cout << "ERROR. File " << filename << " is not a flat waveform file" << endl;
+		Close();
+		return false;
+	}
+	fSampleType = header.fSampleType;
+	fNextOffset = kFlatPageSize;
+	fIndex.clear();
+	Refresh();
+	return true;
+}
+
+Long64_t FlatWaveReader::Refresh () {
+	if (fFD < 0)
+		return 0;
+	// Remap if file has grown
+	struct stat st;
+	if (fstat (fFD, &st) == 0 && (size_t) st.st_size > fMapSize) {
+		if (fMap)
+			munmap (fMap, fMapSize);
+		fMapSize = st.st_size;
+		fMap = (char*) mmap (0, fMapSize, PROT_READ, MAP_SHARED, fFD, 0);
+		if (fMap == MAP_FAILED) {
+			cout << "ERROR. Flat file can't be mapped" << endl;
+			fMap = 0;
+			fMapSize = 0;
+			return 0;
+		}
+	}
+	if (!fMap)
+		return 0;
+
+	const volatile FlatFileHeader *header = (const volatile FlatFileHeader*) fMap;
+	ULong64_t NumWaveforms = header->fNumWaveforms;
+	ULong64_t IndexOffset  = header->fIndexOffset;
+	if (IndexOffset && IndexOffset + NumWaveforms * sizeof(ULong64_t) <= fMapSize) {
+		// Closed file: take complete index
+		const ULong64_t *index = (const ULong64_t*) (fMap + IndexOffset);
+		fIndex.assign (index, index + NumWaveforms);
+		return fIndex.size();
+	}
+	// File is being written: walk through new records
+	while (fIndex.size() < NumWaveforms && fNextOffset + sizeof(FlatWaveHeader) <= fMapSize) {
+		const FlatWaveHeader *wave = (const FlatWaveHeader*) (fMap + fNextOffset);
+		if (memcmp (wave->fMagic, kWaveMagic, sizeof(kWaveMagic)) || wave->fDataSize < 0)
+			break;
+		ULong64_t RecordSize = PageRound (sizeof(FlatWaveHeader) + wave->fDataSize);
+		if (fNextOffset + RecordSize > fMapSize)
+			break;
+		fIndex.push_back (fNextOffset);
+		fNextOffset += RecordSize;
+	}
+	return fIndex.size();
+}
+
+Bool_t FlatWaveReader::GetWaveform (Long64_t i, FlatWaveView &View) {
+	if (i < 0 || i >= (Long64_t) fIndex.size()) {
+		cout << "ERROR. Waveform " << i << " is absent in flat file" << endl;
+		return false;
+	}
+	View.fHeader     = (const FlatWaveHeader*) (fMap + fIndex[i]);
+	View.fData       = fMap + fIndex[i] + sizeof(FlatWaveHeader);
+	View.fSampleType = fSampleType;
+	return true;
+}
+
+void FlatWaveReader::Close () {
+	if (fMap)
+		munmap (fMap, fMapSize);
+	fMap = 0;
+	fMapSize = 0;
+	if (fFD >= 0)
+		close (fFD);
+	fFD = -1;
+	fIndex.clear();
+}
@@ -0,0 +1,130 @@
+#ifndef FlatWaveFile_H
+#define FlatWaveFile_H
+
+#include <vector>
+
+#include <Rtypes.h>
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Flat binary waveform file (alternative to REDFile for local pipelines). //
+//                                                                         //
+// File consists of pages of kFlatPageSize bytes:                          //
+//   page 0      - FlatFileHeader                                          //
+//   then        - waveform records, each starts at page boundary:         //
+//                 FlatWaveHeader + samples (double, int16 or WaveCodec)   //
+//   at the end  - index (offsets of all records), written by Close()      //
+// Header field fNumWaveforms is updated after each record is completely   //
+// written, so the file can be read while it is still being written.       //
+//                                                                         //
+// FlatWaveReader maps file into memory and gives views of waveforms       //
+// pointing directly into the mapping (no copy). Refresh() picks up        //
+// records appended since the last call.                                   //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+static const UInt_t kFlatPageSize = 4096;
+
+// Type of samples in file
+enum FlatSampleType {
+	kFlatDouble = 0, // Samples as they are (ADC units)
+	kFlatInt16  = 1, // Samples rounded to nearest integer and clipped to int16 range
+	kFlatCodec  = 2  // Samples rounded to ADC counts and coded by WaveCodec
+};
+
+struct FlatFileHeader {
+	char      fMagic[8];       // "MWFLAT02" (01 - fDataSize of records was reserved field)
+	UInt_t    fPageSize;       // kFlatPageSize
+	UInt_t    fSampleType;     // FlatSampleType
+	ULong64_t fNumWaveforms;   // Number of completely written records
+	ULong64_t fIndexOffset;    // Offset of index (0 while file is written)
+};
+
+struct FlatWaveHeader {
+	char      fMagic[4];       // "MWWF"
+	Int_t     fChannel;        // Channel in event
+	Long64_t  fEventID;        // Number of event
+	Int_t     fNumSamples;
+	Int_t     fDataSize;       // Size of samples data in bytes
+	Double_t  fPeriod;         // Time between samples
+	Double_t  fGain;           // ADC resolution
+	Double_t  fDelay;          // Time of first sample
+};
+
+// Waveform in mapped file. Valid until next Refresh() or Close() of reader
+struct FlatWaveView {
+	const FlatWaveHeader *fHeader;
+	const void *fData;         // Samples (double, int16 or coded)
+	Int_t fSampleType;
+
+	Int_t    GetNumSamples () const {return fHeader->fNumSamples;}
+	Double_t GetPeriod ()     const {return fHeader->fPeriod;}
+	Double_t GetGain ()       const {return fHeader->fGain;}
+	Double_t GetDelay ()      const {return fHeader->fDelay;}
+	Int_t    GetChannel ()    const {return fHeader->fChannel;}
+	Long64_t GetEventID ()    const {return fHeader->fEventID;}
+	const Double_t* GetDoubles () const {return fSampleType == kFlatDouble ? (const Double_t*) fData : 0;}
+	const Short_t*  GetShorts ()  const {return fSampleType == kFlatInt16  ? (const Short_t*)  fData : 0;}
+	const UChar_t*  GetCoded ()   const {return fSampleType == kFlatCodec  ? (const UChar_t*)  fData : 0;}
+	Int_t GetDataSize ()          const {return fHeader->fDataSize;}
+	// Sample i of double or int16 waveform (use Decode() for coded one)
+	Double_t At (Int_t i) const {
+		return fSampleType == kFlatDouble ? ((const Double_t*) fData)[i] : ((const Short_t*) fData)[i];
+	}
+	Bool_t Decode (vector <double> &Samples) const; // Copy samples of waveform of any type
+};
+
+class FlatWaveWriter
+{
+	public:
+
+		FlatWaveWriter ();
+		~FlatWaveWriter ();
+
+		Bool_t Open (const char *filename, Int_t SampleType = kFlatDouble);
+		Bool_t AddWaveform (Long64_t EventID, Int_t Channel, const Double_t *Samples, Int_t NumSamples,
+		                    Double_t Period, Double_t Gain, Double_t Delay); // Append one record
+		void Close (); // Write index and close file
+		Bool_t IsOpen () {return fFD >= 0;}
+		Long64_t GetNumWaveforms () {return fIndex.size();}
+
+	private:
+
+		Bool_t WriteAt (const void *data, size_t size, ULong64_t offset);
+
+		int fFD;                  // File descriptor
+		Int_t fSampleType;
+		ULong64_t fEnd;           // Offset of the end of file
+		vector <ULong64_t> fIndex; // Offsets of records
+		vector <char> fBuffer;    // Buffer for one record
+		vector <UChar_t> fCoded;  // Coded samples
+};
+
+class FlatWaveReader
+{
+	public:
+
+		FlatWaveReader ();
+		~FlatWaveReader ();
+
+		Bool_t Open (const char *filename);
+		Long64_t Refresh ();      // Map records appended by writer, return number of waveforms
+		void Close ();
+
+		Long64_t GetNumWaveforms () {return fIndex.size();}
+		Bool_t GetWaveform (Long64_t i, FlatWaveView &View); // Zero-copy view of record i
+		ULong64_t GetOffset (Long64_t i) {return fIndex.at(i);} // Byte offset of record i
+
+	private:
+
+		int fFD;
+		char *fMap;               // Mapped file
+		size_t fMapSize;
+		Int_t fSampleType;
+		vector <ULong64_t> fIndex; // Offsets of records
+		ULong64_t fNextOffset;    // Offset of the next record to be indexed
+};
+
+#endif // FlatWaveFile_H
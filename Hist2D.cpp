@@ -0,0 +1,70 @@
+#include <iostream>
+
+#include <TH2F.h>
+
+#include "Hist2D.h"
+
+using std::cout;
+using std::endl;
+
+Hist2D::Hist2D (Int_t NumX, Double_t MinX, Double_t MaxX, Int_t NumY, Double_t MinY, Double_t MaxY) {
+	fNumX   = NumX;
+	fMinX   = MinX;
+	fMaxX   = MaxX;
+	fScaleX = NumX / (MaxX - MinX);
+	fNumY   = NumY;
+	fMinY   = MinY;
+	fMaxY   = MaxY;
+	fScaleY = NumY / (MaxY - MinY);
+	fBins.assign ((size_t) (fNumX + 2) * (fNumY + 2), 0);
+	fEntries = 0;
+}
+
+Bool_t Hist2D::IsCompatible (const Hist2D &Other) const {
+	return fNumX == Other.fNumX && fMinX == Other.fMinX && fMaxX == Other.fMaxX &&
+	       fNumY == Other.fNumY && fMinY == Other.fMinY && fMaxY == Other.fMaxY;
+}
+
+Bool_t Hist2D::Merge (const Hist2D &Other) {
+	if (!IsCompatible (Other)) {
+		cout << "ERROR. Histograms with different bins can't be merged" << endl;
+		return false;
+	}
+	Double_t *Bins = &fBins[0];
+	const Double_t *OtherBins = &Other.fBins[0];
+	for (size_t i = 0; i < fBins.size(); i++)
+		Bins[i] += OtherBins[i];
+	fEntries += Other.fEntries;
+	return true;
+}
+
+void Hist2D::Reset () {
+	fBins.assign (fBins.size(), 0);
+	fEntries = 0;
+}
+
+TH2F* Hist2D::ToTH2F (const char *name, const char *title) const {
+	TH2F *Hist = new TH2F (name, title, fNumX, fMinX, fMaxX, fNumY, fMinY, fMaxY);
+	AddTo (Hist);
+	return Hist;
+}
+
+// SetBinContent changes number of entries, so it is set from value before filling
+void Hist2D::AddTo (TH2 *Hist) const {
+	const TAxis *X = Hist->GetXaxis();
+	const TAxis *Y = Hist->GetYaxis();
+	if (X->GetNbins() != fNumX || X->GetXmin() != fMinX || X->GetXmax() != fMaxX ||
+	    Y->GetNbins() != fNumY || Y->GetXmin() != fMinY || Y->GetXmax() != fMaxY) {
+		cout << "ERROR. Histogram " << Hist->GetName() << " has different bins" << endl;
+		return;
+	}
+	Double_t Entries = Hist->GetEntries();
+	for (Int_t biny = 0; biny <= fNumY + 1; biny++) {
+		for (Int_t binx = 0; binx <= fNumX + 1; binx++) {
+			Double_t Content = GetBinContent (binx, biny);
+			if (Content)
+				Hist->SetBinContent (binx, biny, Hist->GetBinContent (binx, biny) + Content);
+		}
+	}
+	Hist->SetEntries (Entries + fEntries);
+}
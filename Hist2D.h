@@ -0,0 +1,75 @@
+#ifndef Hist2D_H
+#define Hist2D_H
+
+#include <vector>
+
+#include <Rtypes.h>
+
+class TH2;
+class TH2F;
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Lightweight 2D histogram with fixed bins (e.g. F90 vs photoelectrons).  //
+//                                                                         //
+// Unlike TH2F it has no global state (directory, object lists), so each   //
+// worker thread fills its own instance without any locking. Instances     //
+// with the same binning are added by Merge(), periodically or at the end  //
+// of run, by the thread which owns the target (after join or between      //
+// batches). ToTH2F() / AddTo() convert result to ROOT histogram for       //
+// output. Bins are numbered as in ROOT: 0 - underflow, 1..N - bins,       //
+// N+1 - overflow.                                                         //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+class Hist2D
+{
+	public:
+
+		Hist2D (Int_t NumX, Double_t MinX, Double_t MaxX, Int_t NumY, Double_t MinY, Double_t MaxY);
+
+	// GETTERS
+		Int_t GetNumBinsX () const {return fNumX;}
+		Int_t GetNumBinsY () const {return fNumY;}
+		Double_t GetBinContent (Int_t binx, Int_t biny) const {return fBins[binx + (fNumX + 2) * biny];}
+		Long64_t GetEntries () const {return fEntries;}
+		Bool_t IsCompatible (const Hist2D &Other) const; // The same binning
+
+	// ACTIONS
+		void Fill (Double_t x, Double_t y, Double_t w = 1) {
+			if (x != x || y != y) // NaN
+				return;
+			fBins[GetBin (x, fNumX, fMinX, fMaxX, fScaleX) + (fNumX + 2) * GetBin (y, fNumY, fMinY, fMaxY, fScaleY)] += w;
+			fEntries++;
+		}
+		Bool_t Merge (const Hist2D &Other); // Add contents of Other (return false if binning differs)
+		void Reset ();
+		TH2F* ToTH2F (const char *name, const char *title = "") const; // New ROOT histogram with the same contents
+		void AddTo (TH2 *Hist) const; // Add contents to ROOT histogram with the same binning
+
+	private:
+
+		static Int_t GetBin (Double_t v, Int_t Num, Double_t Min, Double_t Max, Double_t Scale) {
+			if (v < Min)
+				return 0;
+			if (v >= Max)
+				return Num + 1;
+			Int_t bin = 1 + (Int_t) ((v - Min) * Scale);
+			return bin > Num ? Num : bin; // Rounding at upper edge
+		}
+
+		Int_t fNumX;
+		Double_t fMinX;
+		Double_t fMaxX;
+		Double_t fScaleX;  // Bins per unit of x
+		Int_t fNumY;
+		Double_t fMinY;
+		Double_t fMaxY;
+		Double_t fScaleY;
+		vector <Double_t> fBins; // (fNumX+2) * (fNumY+2) bins with under/overflow, x changes first
+		Long64_t fEntries;
+};
+
+#endif // Hist2D_H
@@ -1,11 +1,13 @@
 #include <iostream>
+#include <thread>
+#include <cmath>
 
 #include <TRandom3.h>
 #include "SystemOfUnits.h"
-#include <TCanvas.h>
-#include <TGraph.h>
 
 #include "MakeTest.h"
+#include "ElecChain.h"
+#include "CPUDispatch.h"
 
 using std::vector;
 using std::cout;
@@ -15,6 +17,8 @@ using CLHEP::ns;
 MakeTest::MakeTest() {
 	fTimesVec = new vector <Double_t>;
 	fMeanOutWave = new vector <Double_t>;
+	fRMSOutWave = new vector <Double_t>;
+	fNumStarted = 0;
 }
 
 void MakeTest::SetPhotonsTimes (Double_t *TimesArr) {
@@ -25,53 +29,98 @@ void MakeTest::SetPhotonsTimes (Double_t *TimesArr) {
 	}
 }
 
+// Waveforms are rendered in threads of MakeWaveObj, each thread accumulates
+// its own mean and M2 of samples; they are merged at the end.
+// SPE are generated under mutex, since PMT generator is shared, and each
+// thread evaluates its own copy of SPE shape. Noise is seeded by number of
+// waveform, so the average does not depend on number of threads
 void MakeTest::AverageOW (Int_t DebugN, MakeWave* MakeWaveObj) {
+	Int_t NumSamples = MakeWaveObj->GetNumSamples();
+	Int_t NumThreads = MakeWaveObj->GetNumThreads();
+	if (NumThreads > DebugN)
+		NumThreads = DebugN;
+	if (NumThreads < 1)
+		NumThreads = 1;
+	cout << "Averaging " << DebugN << " waveforms in " << NumThreads << " threads" << endl;
 
-	//Double_t Period     = MakeWaveObj -> GetPeriod();
-	//Double_t Gain       = MakeWaveObj -> GetGain();
-	Double_t NumSamples = MakeWaveObj -> GetNumSamples();
-	//Double_t Delay      = MakeWaveObj -> GetDelay();
-
-	cout << "Create vector for mean waveform" << endl;
-	fMeanOutWave->resize (NumSamples);
-	Bool_t ShowAllNum = false; // Report status of each OutWave performing
-	                           // If false - only each 10th step will be showed
-	// Create OutWave
-	if (DebugN < 100) {
-		ShowAllNum = true;
+	vector <WaveStat> Stats (NumThreads);
+	for (Int_t t = 0; t < NumThreads; t++) {
+		Stats[t].fNum = 0;
+		Stats[t].fMean.assign (NumSamples, 0);
+		Stats[t].fM2.assign (NumSamples, 0);
 	}
-	for (int i = 1; i <= DebugN; i++){
-		if (ShowAllNum)
-			cout << "Creating " << i << " waveform" << endl;
-		else{
-			if (!(i % int(floor(DebugN/10)))){
-				cout << "Creating " << i << " waveform" << endl;
-			}
-		}
-		MakeWaveObj->CreateOutWave();
-		for (int k = 0; k < NumSamples; k++){
-			(*fMeanOutWave)[k] += MakeWaveObj->GetOutWave()[k];
+	fNumStarted = 0;
+	if (NumThreads == 1)
+		AverageThread (DebugN, MakeWaveObj, &Stats[0], 0);
+	else {
+		MakeWaveObj->GetPMT()->SetNumThreads (NumThreads);
+		if (MakeWaveObj->GetElecChain())
+			MakeWaveObj->GetElecChain()->SetNumThreads (NumThreads);
+		vector <std::thread> Threads;
+		for (Int_t t = 0; t < NumThreads; t++)
+			Threads.push_back (std::thread (&MakeTest::AverageThread, this, DebugN, MakeWaveObj, &Stats[t], t));
+		for (Int_t t = 0; t < NumThreads; t++)
+			Threads[t].join();
+	}
+
+	for (Int_t t = 1; t < NumThreads; t++)
+		MergeStat (Stats[0], Stats[t]);
+	fMeanOutWave->assign (Stats[0].fMean.begin(), Stats[0].fMean.end());
+	fRMSOutWave->resize (NumSamples);
+	for (Int_t k = 0; k < NumSamples; k++)
+		(*fRMSOutWave)[k] = Stats[0].fNum ? sqrt (Stats[0].fM2[k] / Stats[0].fNum) : 0;
+}
+
+void MakeTest::AverageThread (Int_t DebugN, MakeWave* MakeWaveObj, WaveStat *Stat, Int_t Thread) {
+	Int_t Step = DebugN < 100 ? 1 : DebugN / 10; // Report status of each OutWave if DebugN < 100, of each 10th part otherwise
+	TRandom3 NoiseRND;
+	RED::PMT::PulseArray PhotoElectrons;
+	RED::PMT::PulseArray DarkElectrons;
+	vector <double> OutWave;
+	while (true) {
+		Int_t Event;
+		{
+			std::lock_guard <std::mutex> Lock (fMutex);
+			if (fNumStarted >= DebugN)
+				break;
+			Event = ++fNumStarted;
+			if (!(Event % Step))
+				cout << "Creating " << fNumStarted << " waveform" << endl;
+			const Double_t *Times;
+			Int_t NumPhotons = MakeWaveObj->GetPhotons (Times);
+			MakeWaveObj->GenElectrons (Times, NumPhotons, PhotoElectrons, DarkElectrons);
 		}
+		NoiseRND.SetSeed (MakeWave::GetNoiseSeed (Event));
+		MakeWaveObj->RenderWave (PhotoElectrons, DarkElectrons, OutWave, &NoiseRND, Thread);
+		AddToStat (*Stat, OutWave);
 	}
 }
 
-void MakeTest::DrawOW (MakeWave* MakeWaveObj) {
-	Double_t Period     = MakeWaveObj -> GetPeriod();
-	//Double_t Gain       = MakeWaveObj -> GetGain();
-	Double_t NumSamples = MakeWaveObj -> GetNumSamples();
-	Double_t Delay      = MakeWaveObj -> GetDelay();
+MW_KERNEL void MakeTest::AddToStat (WaveStat &Stat, const vector <double> &Wave) {
+	const Double_t *Sample = Wave.size() ? &Wave[0] : 0;
+	Double_t *Mean = &Stat.fMean[0];
+	Double_t *M2   = &Stat.fM2[0];
+	Int_t NumSamples = std::min (Wave.size(), Stat.fMean.size());
+	Double_t InvNum = 1. / ++Stat.fNum;
+	for (Int_t k = 0; k < NumSamples; k++) {
+		Double_t Delta = Sample[k] - Mean[k];
+		Mean[k] += Delta * InvNum;
+		M2[k]   += Delta * (Sample[k] - Mean[k]);
+	}
+}
 
-	TCanvas *c3 = new TCanvas();
-	c3->cd();
-	c3->SetTitle("OutWave");
-	TGraph *g2  = new TGraph (NumSamples);
-	for (int i = 0; i < NumSamples; i++){
-		g2->SetPoint (i, (Delay + i*Period)/ns, (*fMeanOutWave)[i]);
-		// cout << "point num " << i << "at time= " << (Delay + i*Period)/ns << " ns ";
-		// cout << "with ampl= " << (*fMeanOutWave)[i] << " ADC-units was added" <<endl;
+void MakeTest::MergeStat (WaveStat &Stat, const WaveStat &Other) {
+	if (!Other.fNum)
+		return;
+	Long64_t Num = Stat.fNum + Other.fNum;
+	Double_t Frac = (Double_t) Other.fNum / Num;
+	Double_t Weight = (Double_t) Stat.fNum * Other.fNum / Num;
+	for (unsigned int k = 0; k < Stat.fMean.size(); k++) {
+		Double_t Delta = Other.fMean[k] - Stat.fMean[k];
+		Stat.fMean[k] += Delta * Frac;
+		Stat.fM2[k]   += Other.fM2[k] + Delta * Delta * Weight;
 	}
-	g2->SetTitle("OutWave;Time, ns;Amplitude, ADC units");
-	g2->Draw();
+	Stat.fNum = Num;
 }
 
 void MakeTest::RandPhotonTimes (Int_t number, Double_t leftEdge, Double_t rightEdge) {
@@ -90,22 +139,3 @@ void MakeTest::PrintTimesVec () {
 		cout << ((*fTimesVec)[i])/ns << " ns" << endl;
 	}
 }
-
-void MakeTest::DrawShape (RED::PMT *pmt, Char_t const *title) {
-	TCanvas *c5 = new TCanvas();
-	c5->SetTitle("SPE Shape");
-	c5->cd();
-	switch (pmt->fMode) {
-		case RED::PMT::kModeNone :
-			break;
-		case RED::PMT::kModeF1 :
-			pmt->fShape.func->SetTitle (title);
-			pmt->fShape.func->Draw();
-			break;
-		case RED::PMT::kModeSpline :
-			pmt->fShape.spline->SetTitle (title);
-			pmt->fShape.spline->Draw();
-			break;
-	}
-	//c5->WaitPrimitive();
-}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <vector>
+#include <mutex>
 
 #include <Rtypes.h>
 
@@ -25,17 +26,32 @@ class MakeTest
 
 	//GETTERS
 		vector <Double_t> GetMeanOW  () {return *fMeanOutWave;}
+		vector <Double_t> GetRMSOW   () {return *fRMSOutWave;} // RMS of samples of averaged OutWaves
 		vector <Double_t> GetTimesVec() {return *fTimesVec;}
 
 	//ACTIONS
-		void AverageOW (Int_t DebugN, MakeWave* MakeWaveObj); // Create average OutWave for DebugN OutWaves with the same SPE arrival times
-		void DrawOW (MakeWave* MakeWaveObj);
+		void AverageOW (Int_t DebugN, MakeWave* MakeWaveObj); // Create average OutWave and its RMS for DebugN OutWaves with the same photon arrival times
+		                                                       // (rendered in threads of MakeWaveObj)
+		void DrawOW (MakeWave* MakeWaveObj);   // Drawing is in MakeWaveDraw.cpp (libMakeWaveDraw)
 		void RandPhotonTimes (Int_t number, Double_t leftEdge, Double_t rightEdge); // Set random photon arrival times
 		void PrintTimesVec ();
-		void DrawShape (RED::PMT *pmt, Char_t const *title);
+		void DrawShape (RED::PMT *pmt, Char_t const *title); // MakeWaveDraw.cpp
 
 	private:
 
+		// Running mean and sum of squared deviations of samples (Welford), one per thread
+		struct WaveStat {
+			Long64_t fNum;
+			vector <Double_t> fMean;
+			vector <Double_t> fM2;
+		};
+		void AverageThread (Int_t DebugN, MakeWave* MakeWaveObj, WaveStat *Stat, Int_t Thread); // Render and accumulate waveforms until DebugN are done
+		static void AddToStat (WaveStat &Stat, const vector <double> &Wave); // Welford update of Stat by waveform
+		static void MergeStat (WaveStat &Stat, const WaveStat &Other); // Add Other to Stat (Chan et al.)
+
 		vector <Double_t> *fTimesVec; // vector of arrival times
 		vector <Double_t> *fMeanOutWave; // outwave vector
+		vector <Double_t> *fRMSOutWave;  // RMS of outwave samples
+		std::mutex fMutex;   // Generation of SPE (PMT generator is shared by threads)
+		Int_t fNumStarted;   // Waveforms taken by threads
 };
\ No newline at end of file
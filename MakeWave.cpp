@@ -1,21 +1,63 @@
 #include <iostream>
+#include <algorithm>
+#include <thread>
 
-#include <TCanvas.h>
-#include <TH1.h>
-#include <TGraph.h>
+#include <TROOT.h>
 
 #include "MakeWave.h"
+#include "PulseFile.h"
+#include "FlatWaveFile.h"
+#include "WaveCodec.h"
+#include "Trigger.h"
+#include "ElecChain.h"
+#include "WaveBatch.h"
 
 using std::cout;
 using std::endl;
 
+// Order of pulses by time
+static bool PulseTimeLess (const RED::PMT::Pulse &a, const RED::PMT::Pulse &b) {
+	return a.fTime < b.fTime;
+}
+
 // Simple constructor
 MakeWave::MakeWave () {
 	fPhotoElectrons   = 0;
 	fDarkElectrons    = 0;
 	fPMT              = 0;
 	fPulseAreaHist    = 0;
-	fOutFile          = 0;
+	fWriter           = 0;
+	fWritePool        = 64;
+	fWriteCompression = -1;
+	fWriteFlushBytes  = 0;
+	fNumEntries       = 0;
+	fLastEntry        = -1;
+	fPulseFile        = 0;
+	fFlatFile         = 0;
+	fCompress         = false;
+	fTrigger          = 0;
+	fElecChain        = 0;
+	fPhotonTimes      = 0;
+	fPhotonData       = 0;
+	fNumPhotons       = 0;
+	fPhotonChannels   = 0;
+	fLightMap         = 0;
+	fWorkEvent        = 0;
+	fNumBusy          = 0;
+	fStopWorkers      = false;
+	fNumThreads       = 1;
+	SetNumThreads (std::thread::hardware_concurrency());
+	fRND.SetSeed(0);
+}
+
+MakeWave::~MakeWave () {
+	StopWorkers();
+	for (unsigned int ch = 0; ch < fChannels.size(); ch++)
+		delete fChannels[ch].fNoiseRND;
+	ClearOutConfigs();
+	delete fPhotoElectrons;
+	delete fDarkElectrons;
+	delete fWriter; // Pooled events are written
 }
 
 // Set PMT
@@ -41,34 +83,221 @@ void MakeWave::SetDefaults(){
 
 // Set sequence of photon times
 void MakeWave::SetPhotonTimes (vector <double>* PhotonTimes) {
-	fPhotonTimes = PhotonTimes;
+	fPhotonTimes    = PhotonTimes;
+	fPhotonChannels = 0;
+}
+
+// Set photon times from external buffer (it must live until event is created)
+void MakeWave::SetPhotonTimes (const Double_t *Times, Int_t NumPhotons, const Short_t *Channels) {
+	fPhotonTimes    = 0;
+	fPhotonData     = Times;
+	fNumPhotons     = NumPhotons;
+	fPhotonChannels = Channels;
+}
+
+Int_t MakeWave::GetPhotons (const Double_t *&Times) {
+	if (fPhotonTimes) {
+		Times = fPhotonTimes->size() ? &(*fPhotonTimes)[0] : 0;
+		return fPhotonTimes->size();
+	}
+	Times = fPhotonData;
+	return fNumPhotons;
+}
+
+// Add channel of multi-channel detector
+void MakeWave::AddChannel (RED::PMT* pmt, Double_t TimeOffset, Double_t Gain) {
+	Channel ch;
+	ch.fPMT         = pmt;
+	ch.fTimeOffset  = TimeOffset;
+	ch.fGain        = Gain;
+	ch.fPhotonTimes = 0;
+	ch.fNoiseRND    = new TRandom3 (fChannels.size() + 1);
+	fChannels.push_back (ch);
+}
+
+// Set sequence of photon times for one channel
+void MakeWave::SetChannelPhotonTimes (Int_t ch, vector <double>* PhotonTimes) {
+	fChannels.at(ch).fPhotonTimes = PhotonTimes;
+}
+
+// Set light map. Photons from SetPhotonTimes will be distributed between channels
+// with probabilities LightMap[ch]. If sum of them exceeds 1, they are normalized
+void MakeWave::SetLightMap (vector <double>* LightMap) {
+	fLightMap = LightMap;
+}
+
+// ROOT is made thread-safe once here, rendering threads are started by first event
+void MakeWave::SetNumThreads (Int_t NumThreads) {
+	if (NumThreads < 1)
+		NumThreads = 1;
+	if (NumThreads != fNumThreads)
+		StopWorkers();
+	fNumThreads = NumThreads;
+	if (fNumThreads > 1)
+		ROOT::EnableThreadSafety();
+}
+
+// All random numbers of event are taken from generators seeded here, PMT and
+// SimPhotons (see RunConfig::SetEventSeed), so event is reproducible alone
+void MakeWave::SetSeed (UInt_t Seed) {
+	fRND.SetSeed (Seed);
+	if (fElecChain)
+		fElecChain->SetSeed (GetNoiseSeed (Seed));
+	for (unsigned int ch = 0; ch < fChannels.size(); ch++)
+		fChannels[ch].fNoiseRND->SetSeed (GetNoiseSeed (Seed, ch));
+}
+
+UInt_t MakeWave::GetNoiseSeed (UInt_t Seed, Int_t ch) {
+	UInt_t NoiseSeed = Seed * 0x9E3779B1u + 2*ch + 1; // Odd multiplier - different seeds for different Seed
+	return NoiseSeed ? NoiseSeed : 1; // 0 is random seed for TRandom3
+}
+
+// Policy for REDFile created by next GetNewFile
+void MakeWave::SetFilePolicy (Int_t PoolSize, Int_t Compression, Long64_t FlushBytes) {
+	fWritePool        = PoolSize > 0 ? PoolSize : 1;
+	fWriteCompression = Compression;
+	fWriteFlushBytes  = FlushBytes;
+}
+
+// Add output configuration. The same SPE will be rendered with it by CreateOutWaves
+Int_t MakeWave::AddOutConfig (Double_t Period, Double_t Gain, Int_t NumSamples, Double_t Delay, RED::PMT *Shape) {
+	if (!Shape)
+		Shape = fPMT;
+	if (NumSamples <= 0 || !Shape) {
+		cout << "ERROR. Output configuration needs samples and PMT" << endl;
+		return -1;
+	}
+	OutConfig Config;
+	Config.fPeriod     = Period;
+	Config.fGain       = Gain;
+	Config.fNumSamples = NumSamples;
+	Config.fDelay      = Delay;
+	// Find table for the same shape or create new one
+	Config.fShape = 0;
+	for (unsigned int i = 0; i < fShapeTables.size(); i++) {
+		if (fShapeTables[i]->GetPMT() == Shape)
+			Config.fShape = fShapeTables[i];
+	}
+	if (!Config.fShape) {
+		Config.fShape = new ShapeTable (Shape);
+		fShapeTables.push_back (Config.fShape);
+	}
+	fOutConfigs.push_back (Config);
+	return fOutConfigs.size() - 1;
+}
+
+void MakeWave::ClearOutConfigs () {
+	for (unsigned int i = 0; i < fShapeTables.size(); i++)
+		delete fShapeTables[i];
+	fShapeTables.clear();
+	fOutConfigs.clear();
+}
+
+// Photon at time t gives SPE at t + [DelayMin, DelayMax] (plus time offset of channel),
+// pulse of SPE covers [Xmin, Xmax] around its time
+void MakeWave::GetPhotonWindow (Double_t &Begin, Double_t &End) {
+	Bool_t First = true;
+	Begin = End = 0;
+	if (fChannels.size()) {
+		for (unsigned int ch = 0; ch < fChannels.size(); ch++) {
+			Channel &Ch = fChannels[ch];
+			Double_t b = fDelay - Ch.fTimeOffset - Ch.fPMT->GetXmax() - Ch.fPMT->GetDelayMax();
+			Double_t e = fDelay + fNumSamples * fPeriod - Ch.fTimeOffset - Ch.fPMT->GetXmin() - Ch.fPMT->GetDelayMin();
+			if (First || b < Begin) Begin = b;
+			if (First || e > End)   End   = e;
+			First = false;
+		}
+	}
+	else if (fPMT) {
+		Begin = fDelay - fPMT->GetXmax() - fPMT->GetDelayMax();
+		End   = fDelay + fNumSamples * fPeriod - fPMT->GetXmin() - fPMT->GetDelayMin();
+		First = false;
+	}
+	for (unsigned int k = 0; k < fOutConfigs.size(); k++) {
+		OutConfig &Config = fOutConfigs[k];
+		const RED::PMT *pmt = Config.fShape->GetPMT(); // PMT of configuration (fPMT may be 0 in channel mode)
+		if (!pmt)
+			continue;
+		Double_t b = Config.fDelay - Config.fShape->GetXmax() - pmt->GetDelayMax();
+		Double_t e = Config.fDelay + Config.fNumSamples * Config.fPeriod - Config.fShape->GetXmin() - pmt->GetDelayMin();
+		if (First || b < Begin) Begin = b;
+		if (First || e > End)   End   = e;
+		First = false;
+	}
+}
+
+// The same waveforms with the same parameters as WriteWaves writes
+const Double_t* MakeWave::GetOutWaveData (Int_t k, Int_t &NumSamples, Double_t &Period, Double_t &Gain, Double_t &Delay) {
+	const vector <double> *Wave = &fOutWave;
+	Period = fPeriod;
+	Gain   = fGain;
+	Delay  = fDelay;
+	if (fChannels.size()) {
+		Wave = &fChannels.at(k).fOutWave;
+		if (fChannels[k].fGain)
+			Gain = fChannels[k].fGain;
+	}
+	else if (fOutConfigs.size()) {
+		OutConfig &Config = fOutConfigs.at(k);
+		Wave   = &Config.fOutWave;
+		Period = Config.fPeriod;
+		Gain   = Config.fGain;
+		Delay  = Config.fDelay;
+	}
+	NumSamples = Wave->size();
+	return NumSamples ? &(*Wave)[0] : 0;
+}
+
+const RED::PMT::PulseArray* MakeWave::GetOutWavePulses (Int_t k, Bool_t Dark) {
+	if (fChannels.size())
+		return Dark ? &fChannels.at(k).fDarkElectrons : &fChannels.at(k).fPhotoElectrons;
+	return Dark ? fDarkElectrons : fPhotoElectrons;
+}
+
+Int_t MakeWave::GetNumPE () {
+	if (!fChannels.size())
+		return fPhotoElectrons->size();
+	Int_t NumPE = 0;
+	for (unsigned int ch = 0; ch < fChannels.size(); ch++)
+		NumPE += fChannels[ch].fPhotoElectrons.size();
+	return NumPE;
 }
 
 Double_t MakeWave::GetFrac (Double_t FracWindow, Double_t TotalWindow) {
+	if (!fChannels.size())
+		return GetFrac (*fPhotoElectrons, FracWindow, TotalWindow);
+	// Light of all channels together
+	RED::PMT::PulseArray AllElectrons;
+	for (unsigned int ch = 0; ch < fChannels.size(); ch++)
+		AllElectrons.insert (AllElectrons.end(), fChannels[ch].fPhotoElectrons.begin(), fChannels[ch].fPhotoElectrons.end());
+	return GetFrac (AllElectrons, FracWindow, TotalWindow);
+}
+
+Double_t MakeWave::GetFrac (const RED::PMT::PulseArray &Pulses, Double_t FracWindow, Double_t TotalWindow) {
 
-	if (fPhotoElectrons->size()) {
+	if (Pulses.size()) {
 		// Find min of delays
-		Double_t minDelay = (fPhotoElectrons->at(0)).fTime;
-		for (unsigned int i = 0; i < fPhotoElectrons->size(); i++) {
-			if (minDelay > (fPhotoElectrons->at(i)).fTime)
-				minDelay = (fPhotoElectrons->at(i)).fTime;
+		Double_t minDelay = Pulses[0].fTime;
+		for (unsigned int i = 0; i < Pulses.size(); i++) {
+			if (minDelay > Pulses[i].fTime)
+				minDelay = Pulses[i].fTime;
 		}
 		// Calculate integrals in both windows
 		Double_t TotalSum = 0;
 		Double_t FracSum = 0;
 		if (!TotalWindow) {		
-			for (unsigned int i = 0; i < fPhotoElectrons->size(); i++) {
-				TotalSum += (fPhotoElectrons->at(i)).fAmpl;
-				if ((fPhotoElectrons->at(i)).fTime - minDelay < FracWindow)
-					FracSum += (fPhotoElectrons->at(i)).fAmpl;
+			for (unsigned int i = 0; i < Pulses.size(); i++) {
+				TotalSum += Pulses[i].fAmpl;
+				if (Pulses[i].fTime - minDelay < FracWindow)
+					FracSum += Pulses[i].fAmpl;
 			}
 		}
 		else {
-			for (unsigned int i = 0; i < fPhotoElectrons->size(); i++) {
-				if ((fPhotoElectrons->at(i)).fTime - minDelay < TotalWindow) {
-					TotalSum += (fPhotoElectrons->at(i)).fAmpl;
-					if ((fPhotoElectrons->at(i)).fTime - minDelay < FracWindow)
-						FracSum += (fPhotoElectrons->at(i)).fAmpl;
+			for (unsigned int i = 0; i < Pulses.size(); i++) {
+				if (Pulses[i].fTime - minDelay < TotalWindow) {
+					TotalSum += Pulses[i].fAmpl;
+					if (Pulses[i].fTime - minDelay < FracWindow)
+						FracSum += Pulses[i].fAmpl;
 				}
 			}
 		}
@@ -81,34 +310,247 @@ Double_t MakeWave::GetFrac (Double_t FracWindow, Double_t TotalWindow) {
 
 // Creating OutWave
 void MakeWave::CreateOutWave () {
-	fOutWave.clear ();                //  Clear vector OutWave
-	fOutWave.resize (fNumSamples, 0); // Resize vector OutWave
+	if (fChannels.size()) {
+		CreateChannelWaves();
+		return;
+	}
+	CreatePulses();
+	RenderWave (*fPhotoElectrons, *fDarkElectrons, fOutWave);
 
-	// ADD SPE FROM PHOTONS
+	//cout << "OutWave was created" << endl;
+}
 
-	// Check if PulseArray vector fPhotoElectrons exists
+// Creating SPE caused by photons and dark counts
+void MakeWave::CreatePulses () {
+	// Check if PulseArray vectors fPhotoElectrons and fDarkElectrons exist
 	if (!fPhotoElectrons)
 		fPhotoElectrons = new RED::PMT::PulseArray;
-	else fPhotoElectrons->clear();
-
-	// Generate fPhotoElectrons, add them to OutWave
-	for (unsigned int i = 0; i < fPhotonTimes->size(); i++) {
-		fPMT->OnePhoton (fPhotonTimes->at(i), *fPhotoElectrons, false);
-	}
-	AddPulseArray (fPhotoElectrons);
+	if (!fDarkElectrons)
+		fDarkElectrons = new RED::PMT::PulseArray;
 
-	// ADD DARK COUNTS
+	const Double_t *Times;
+	Int_t NumPhotons = GetPhotons (Times);
+	GenElectrons (Times, NumPhotons, *fPhotoElectrons, *fDarkElectrons);
+}
 
-	// Check if PulseArray vector fDarkElectrons exists
+// Create OutWave for each output configuration from the same SPE.
+// Dark counts are generated in union of windows of all configurations.
+// All SPE are sorted by time and rendered in single pass: each pulse is added
+// to all waveforms while its table of SPE shape is hot in cache
+void MakeWave::CreateOutWaves () {
+	if (!fOutConfigs.size()) {
+		cout << "ERROR. No output configurations were added" << endl;
+		return;
+	}
+	if (!fPhotoElectrons)
+		fPhotoElectrons = new RED::PMT::PulseArray;
 	if (!fDarkElectrons)
 		fDarkElectrons = new RED::PMT::PulseArray;
-	else fDarkElectrons->clear();
 
-	// Generate dark electrons and add them to OutWave
-	fPMT->GenDCR (fDelay - (fPMT->GetXmax() - fPMT->GetXmin()), fDelay + fNumSamples * fPeriod, *fDarkElectrons);
-	AddPulseArray (fDarkElectrons);
+	// Photoelectrons
+	fPhotoElectrons->clear();
+	const Double_t *Times;
+	Int_t NumPhotons = GetPhotons (Times);
+	if (NumPhotons)
+		fPMT->ManyPhotons (Times, NumPhotons, *fPhotoElectrons);
 
-	//cout << "OutWave was created" << endl;
+	// Dark counts in union of windows
+	Double_t Begin = fOutConfigs[0].fDelay;
+	Double_t End   = fOutConfigs[0].fDelay + fOutConfigs[0].fNumSamples * fOutConfigs[0].fPeriod;
+	Double_t Width = 0;
+	for (unsigned int k = 0; k < fOutConfigs.size(); k++) {
+		OutConfig &Config = fOutConfigs[k];
+		if (Begin > Config.fDelay)
+			Begin = Config.fDelay;
+		if (End < Config.fDelay + Config.fNumSamples * Config.fPeriod)
+			End = Config.fDelay + Config.fNumSamples * Config.fPeriod;
+		if (Width < Config.fShape->GetXmax() - Config.fShape->GetXmin())
+			Width = Config.fShape->GetXmax() - Config.fShape->GetXmin();
+		Config.fOutWave.assign (Config.fNumSamples, 0);
+	}
+	fDarkElectrons->clear();
+	fPMT->GenDCR (Begin - Width, End, *fDarkElectrons);
+
+	// Sorted list of all SPE
+	fSortedPulses.assign (fPhotoElectrons->begin(), fPhotoElectrons->end());
+	fSortedPulses.insert (fSortedPulses.end(), fDarkElectrons->begin(), fDarkElectrons->end());
+	std::sort (fSortedPulses.begin(), fSortedPulses.end(), PulseTimeLess);
+
+	// Single pass over pulses
+	for (unsigned int i = 0; i < fSortedPulses.size(); i++) {
+		for (unsigned int k = 0; k < fOutConfigs.size(); k++) {
+			OutConfig &Config = fOutConfigs[k];
+			Config.fShape->AddPulse (Config.fOutWave.size() ? &Config.fOutWave[0] : 0, Config.fOutWave.size(), Config.fPeriod,
+			                         fSortedPulses[i].fTime - Config.fDelay, fSortedPulses[i].fAmpl / Config.fGain);
+		}
+	}
+	if (fElecChain)
+		for (unsigned int k = 0; k < fOutConfigs.size(); k++)
+			fElecChain->Apply (fOutConfigs[k].fOutWave, fOutConfigs[k].fPeriod);
+}
+
+// Generate SPE from photons and dark counts
+void MakeWave::GenElectrons (const vector <double> &PhotonTimes, RED::PMT::PulseArray &PhotoElectrons,
+                             RED::PMT::PulseArray &DarkElectrons) {
+	GenElectrons (PhotonTimes.size() ? &PhotonTimes[0] : 0, PhotonTimes.size(), PhotoElectrons, DarkElectrons);
+}
+
+void MakeWave::GenElectrons (const Double_t *PhotonTimes, Int_t NumPhotons, RED::PMT::PulseArray &PhotoElectrons,
+                             RED::PMT::PulseArray &DarkElectrons) {
+	PhotoElectrons.clear();
+	if (NumPhotons)
+		fPMT->ManyPhotons (PhotonTimes, NumPhotons, PhotoElectrons);
+	DarkElectrons.clear();
+	fPMT->GenDCR (fDelay - (fPMT->GetXmax() - fPMT->GetXmin()), fDelay + fNumSamples * fPeriod, DarkElectrons);
+}
+
+// Create waveform from SPE caused by photons and dark counts
+void MakeWave::RenderWave (const RED::PMT::PulseArray &PhotoElectrons, const RED::PMT::PulseArray &DarkElectrons,
+                           vector <double> &OutWave, TRandom *NoiseRND, Int_t Thread) {
+	OutWave.assign (fNumSamples, 0);
+	RenderWave (PhotoElectrons, DarkElectrons, &OutWave[0], fNumSamples, NoiseRND, Thread);
+}
+
+void MakeWave::RenderWave (const RED::PMT::PulseArray &PhotoElectrons, const RED::PMT::PulseArray &DarkElectrons,
+                           Double_t *OutWave, Int_t NumSamples, TRandom *NoiseRND, Int_t Thread) {
+	if (NumSamples > fNumSamples)
+		NumSamples = fNumSamples;
+	if (NumSamples <= 0)
+		return;
+	std::fill (OutWave, OutWave + NumSamples, 0.);
+	AddPulseArray (PhotoElectrons, OutWave, NumSamples, fPMT, fGain, Thread);
+	AddPulseArray (DarkElectrons,  OutWave, NumSamples, fPMT, fGain, Thread);
+	if (fElecChain)
+		fElecChain->Apply (OutWave, NumSamples, fPeriod, NoiseRND, Thread);
+}
+
+// Creating OutWave for each channel.
+// Photoelectrons are generated sequentially since several channels may share
+// one PMT object (and its random generator), then channels are rendered in parallel
+void MakeWave::CreateChannelWaves () {
+	if (fLightMap || fPhotonChannels)
+		DistributePhotons();
+
+	for (unsigned int ch = 0; ch < fChannels.size(); ch++) {
+		Channel &Ch = fChannels[ch];
+		Ch.fPhotoElectrons.clear();
+		Ch.fDarkElectrons.clear();
+		if (Ch.fPhotonTimes && Ch.fPhotonTimes->size())
+			Ch.fPMT->ManyPhotons (&Ch.fPhotonTimes->at(0), Ch.fPhotonTimes->size(), Ch.fPhotoElectrons, Ch.fTimeOffset);
+		Ch.fPMT->GenDCR (fDelay - (Ch.fPMT->GetXmax() - Ch.fPMT->GetXmin()), fDelay + fNumSamples * fPeriod, Ch.fDarkElectrons);
+	}
+
+	Int_t NumThreads = fNumThreads;
+	if (NumThreads > (Int_t) fChannels.size())
+		NumThreads = fChannels.size();
+	if (NumThreads <= 1) {
+		RenderChannels (0, 1);
+		return;
+	}
+	// Channels may share PMT: each thread evaluates its own copy of SPE shape
+	for (unsigned int ch = 0; ch < fChannels.size(); ch++)
+		fChannels[ch].fPMT->SetNumThreads (NumThreads);
+	if (fElecChain)
+		fElecChain->SetNumThreads (NumThreads);
+	if ((Int_t) fWorkers.size() != NumThreads - 1) {
+		StopWorkers();
+		for (Int_t t = 1; t < NumThreads; t++)
+			fWorkers.push_back (std::thread (&MakeWave::ChannelWorker, this, t, NumThreads, fWorkEvent));
+	}
+	{
+		std::lock_guard <std::mutex> Lock (fWorkMutex);
+		fNumBusy = fWorkers.size();
+		fWorkEvent++;
+	}
+	fWorkStart.notify_all();
+	RenderChannels (0, NumThreads);
+	std::unique_lock <std::mutex> Lock (fWorkMutex);
+	fWorkDone.wait (Lock, [this] {return fNumBusy == 0;});
+}
+
+void MakeWave::ChannelWorker (Int_t First, Int_t Step, Long64_t Done) {
+	while (true) {
+		{
+			std::unique_lock <std::mutex> Lock (fWorkMutex);
+			fWorkStart.wait (Lock, [this, Done] {return fStopWorkers || fWorkEvent != Done;});
+			if (fStopWorkers)
+				return;
+			Done = fWorkEvent;
+		}
+		RenderChannels (First, Step);
+		{
+			std::lock_guard <std::mutex> Lock (fWorkMutex);
+			fNumBusy--;
+		}
+		fWorkDone.notify_one();
+	}
+}
+
+void MakeWave::StopWorkers () {
+	if (!fWorkers.size())
+		return;
+	{
+		std::lock_guard <std::mutex> Lock (fWorkMutex);
+		fStopWorkers = true;
+	}
+	fWorkStart.notify_all();
+	for (unsigned int t = 0; t < fWorkers.size(); t++)
+		fWorkers[t].join();
+	fWorkers.clear();
+	fStopWorkers = false;
+}
+
+// Distribute photons between channels due to channels given with photon times or fLightMap
+void MakeWave::DistributePhotons () {
+	Int_t NumCh = fChannels.size();
+	for (Int_t ch = 0; ch < NumCh; ch++) {
+		fChannels[ch].fMapTimes.clear();
+		fChannels[ch].fPhotonTimes = &fChannels[ch].fMapTimes;
+	}
+	const Double_t *Times;
+	Int_t NumPhotons = GetPhotons (Times);
+	if (fPhotonChannels) {
+		for (Int_t i = 0; i < NumPhotons; i++) {
+			Int_t ch = fPhotonChannels[i];
+			if (ch >= 0 && ch < NumCh)
+				fChannels[ch].fMapTimes.push_back (Times[i]);
+		}
+		return;
+	}
+	if ((Int_t) fLightMap->size() < NumCh) {
+		cout << "ERROR. Light map has " << fLightMap->size() << " entries for " << NumCh << " channels" << endl;
+		for (Int_t ch = 0; ch < NumCh; ch++)
+			fChannels[ch].fPhotonTimes = 0; // No photons in channels
+		return;
+	}
+	// Cumulative probabilities
+	vector <double> CumProb (NumCh);
+	Double_t Sum = 0;
+	for (Int_t ch = 0; ch < NumCh; ch++) {
+		Sum += fLightMap->at(ch);
+		CumProb[ch] = Sum;
+	}
+	if (Sum < 1)
+		Sum = 1; // The rest of light is lost
+	for (Int_t i = 0; i < NumPhotons; i++) {
+		Double_t RND = fRND.Rndm() * Sum;
+		Int_t ch = std::upper_bound (CumProb.begin(), CumProb.end(), RND) - CumProb.begin();
+		if (ch < NumCh)
+			fChannels[ch].fMapTimes.push_back (Times[i]);
+	}
+}
+
+// Render waveforms of channels First, First+Step, ...
+void MakeWave::RenderChannels (Int_t First, Int_t Step) {
+	for (unsigned int ch = First; ch < fChannels.size(); ch += Step) {
+		Channel &Ch = fChannels[ch];
+		Double_t Gain = Ch.fGain ? Ch.fGain : fGain;
+		Ch.fOutWave.assign (fNumSamples, 0);
+		AddPulseArray (Ch.fPhotoElectrons, Ch.fOutWave, Ch.fPMT, Gain, First);
+		AddPulseArray (Ch.fDarkElectrons,  Ch.fOutWave, Ch.fPMT, Gain, First);
+		if (fElecChain)
+			fElecChain->Apply (Ch.fOutWave, fPeriod, Ch.fNoiseRND, First);
+	}
 }
 
 // Print OutWave
@@ -119,106 +561,228 @@ void MakeWave::PrintOutWave() {
 	cout << "End of OutWave" << endl;
 }
 
-// Draw histograms
-void MakeWave::DrawHists() {
+void MakeWave::AddToFile () {
+	fLastEntry = -1;
+	if (fTrigger && !ApplyTrigger (fOutWave))
+		return; // Event is rejected by trigger
+	fLastEntry = fNumEntries++;
+	if (fPulseFile) {
+		if (fChannels.size())
+			cout << "ERROR. Pulse file is not supported for multi-channel detector" << endl;
+		else {
+			const Double_t *Times;
+			fPulseFile->AddEvent (GetPhotons (Times), *fPhotoElectrons, *fDarkElectrons);
+		}
+		if (!fWriter && !fFlatFile)
+			return; // Truth-level output only
+	}
+	WriteWaves (fOutWave);
+}
+
+void MakeWave::AddToFile (const vector <double> &OutWave) {
+	fLastEntry = -1;
+	if (fTrigger && !ApplyTrigger (OutWave))
+		return;
+	fLastEntry = fNumEntries++;
+	WriteWaves (OutWave);
+}
 
-	// For pulse area
-	if (!fPulseAreaHist) {
-		Double_t Low_Area  = 0;
-		Double_t High_Area = 3*fPMT->GetArea()/(ns*mV);
-		fPulseAreaHist  = new TH1F ("fPulseAreaHist","PulseArea[mV*ns]",1000, Low_Area, High_Area);
+// Write all events of batch (SPE to pulse file, waveforms to REDFile and flat file)
+void MakeWave::AddBatchToFile (const WaveBatch &Batch, vector <Long64_t> *Entries) {
+	if (Entries)
+		Entries->assign (Batch.GetNumEvents(), -1);
+	if (fChannels.size() || fOutConfigs.size()) {
+		cout << "ERROR. Batch is supported only for single channel" << endl;
+		return;
 	}
-	for (unsigned int i=0; i< fPhotoElectrons->size(); i++) {
-		RED::PMT::Pulse OnePulse = (*fPhotoElectrons).at(i);
-		fPulseAreaHist->Fill (OnePulse.fAmpl * fPMT->GetShapeArea() / (mV*ns));
+	for (Int_t ev = 0; ev < Batch.GetNumEvents(); ev++) {
+		const Double_t *Wave = Batch.GetWave (ev);
+		fLastEntry = -1;
+		if (fTrigger && !ApplyTrigger (Wave, Batch.GetNumSamples()))
+			continue;
+		fLastEntry = fNumEntries++;
+		if (Entries)
+			(*Entries)[ev] = fLastEntry;
+		if (fPulseFile) {
+			fPulseFile->AddEvent (Batch.GetNumPhotons (ev), Batch.GetPhotoElectrons (ev), Batch.GetDarkElectrons (ev));
+			if (!fWriter && !fFlatFile)
+				continue;
+		}
+		WriteWaves (Wave, Batch.GetNumSamples());
 	}
-	TCanvas *c3 = new TCanvas();
-	c3->SetTitle("Pulse Area");
-	c3->cd();
-	c3->SetLogy();
-	fPulseAreaHist->Draw();
 }
 
-// Draw OutWave
-void MakeWave::DrawOutWave () {
-	TCanvas *c1 = new TCanvas();
-	c1->cd();
-	TGraph  *g1 = new TGraph(fNumSamples);
-	for (int i = 0; i < fNumSamples; i++) {
-		g1->SetPoint(i, (fDelay + i*fPeriod)/ns, fOutWave.at(i));
+// In multi-channel (multi-configuration) mode waveforms of all channels (configurations) are written instead of OutWave
+void MakeWave::WriteWaves (const Double_t *OutWave, Int_t NumSamples) {
+	if (!fWriter && !fFlatFile) {
+		cout << "ERROR. File was not created" << endl;
+		return;
 	}
-	g1->SetTitle("Waveform");
-	g1->Draw();
+	if (fChannels.size()) {
+		for (unsigned int ch = 0; ch < fChannels.size(); ch++) {
+			const vector <double> &Wave = fChannels[ch].fOutWave;
+			WriteWaveform (ch, Wave.size() ? &Wave[0] : 0, Wave.size(), fPeriod,
+			               fChannels[ch].fGain ? fChannels[ch].fGain : fGain, fDelay);
+		}
+	}
+	else if (fOutConfigs.size()) {
+		for (unsigned int k = 0; k < fOutConfigs.size(); k++) {
+			OutConfig &Config = fOutConfigs[k];
+			WriteWaveform (k, Config.fOutWave.size() ? &Config.fOutWave[0] : 0, Config.fOutWave.size(),
+			               Config.fPeriod, Config.fGain, Config.fDelay);
+		}
+	}
+	else
+		WriteWaveform (0, OutWave, NumSamples, fPeriod, fGain, fDelay);
+	if (fFlatFile)
+		fFlatNumEv++;
+	if (fWriter)
+		fWriter->Commit(); // Events are written when pool of writer is full
 }
 
-void MakeWave::SaveOutWave (const char *filename, const char *title) {
-	TCanvas *c1 = new TCanvas();
-	c1->cd();
-	TGraph  *g1 = new TGraph(fNumSamples);
-	for (int i = 0; i < fNumSamples; i++) {
-		g1->SetPoint(i, (fDelay + i*fPeriod)/ns, fOutWave.at(i));
+// Put waveform (only ROI if trigger is set) to flat file and REDFile event (coded by WaveCodec if compression is on)
+void MakeWave::WriteWaveform (Int_t ch, const Double_t *Wave, Int_t NumSamples,
+                              Double_t Period, Double_t Gain, Double_t Delay) {
+	Int_t First = 0;
+	Int_t Num   = NumSamples;
+	if (fTrigger)
+		GetROI (Period, Delay, NumSamples, First, Num);
+	const Double_t *ROI = Num ? &Wave[First] : 0; // Waveform may be empty (e.g. not rendered)
+	if (fFlatFile)
+		fFlatFile->AddWaveform (fFlatNumEv, ch, ROI, Num, Period, Gain, Delay + First*Period);
+	if (fWriter && fWriter->IsOpen()) {
+		RED::Waveform *Waveform = fWriter->GetWaveform (ch);
+		Waveform->fNumSamples = Num;
+		Waveform->fDelay      = Delay + First*Period;
+		if (fCompress)
+			WaveCodec::Pack (ROI, Num, Waveform->fData);
+		else
+			Waveform->fData.assign(ROI, ROI + Num);
 	}
-	g1->SetTitle(title);
-	g1->SaveAs(filename);
 }
 
-void MakeWave::AddToFile () {
-	if (fOutFile) {
-		if (fOutFile->IsOpen()) {
-			fWaveform->fData.assign(fOutWave.begin(), fOutWave.end());
-			fOutFile->WriteEvent(fEvent);
-			fNumEv++;
-		}
-		else  {
-			cout << "ERROR. File can't be written" << endl;
-		}
+// Trigger on channels (first configuration, OutWave), keep ROI as time interval
+Bool_t MakeWave::ApplyTrigger (const Double_t *OutWave, Int_t NumSamples) {
+	Int_t First = 0;
+	Int_t Last  = 0;
+	Bool_t Accept;
+	Double_t Period = fPeriod;
+	Double_t Delay  = fDelay;
+	// Trigger works on rendered waveforms only (not with CreatePulses)
+	Bool_t Rendered = fChannels.size() ? fChannels[0].fOutWave.size() == (size_t) fNumSamples :
+	                  fOutConfigs.size() ? fOutConfigs[0].fOutWave.size() > 0 : NumSamples > 0 && OutWave;
+	for (unsigned int ch = 1; ch < fChannels.size(); ch++)
+		Rendered = Rendered && fChannels[ch].fOutWave.size() == (size_t) fNumSamples;
+	if (!Rendered) {
+		cout << "ERROR. Trigger needs rendered waveforms, event is rejected" << endl;
+		return false;
 	}
-	else {
-		cout << "ERROR. File was not created" << endl;
+	if (fChannels.size()) {
+		fTriggerWaves.resize (fChannels.size());
+		for (unsigned int ch = 0; ch < fChannels.size(); ch++)
+			fTriggerWaves[ch] = &fChannels[ch].fOutWave[0];
+		Accept = fTrigger->Process (&fTriggerWaves[0], fTriggerWaves.size(), fNumSamples, fPeriod, First, Last);
 	}
+	else if (fOutConfigs.size()) {
+		Period = fOutConfigs[0].fPeriod;
+		Delay  = fOutConfigs[0].fDelay;
+		Accept = fTrigger->Process (fOutConfigs[0].fOutWave, Period, First, Last);
+	}
+	else
+		Accept = fTrigger->Process (&OutWave, 1, NumSamples, fPeriod, First, Last);
+	fROIBegin = Delay + First*Period;
+	fROIEnd   = Delay + Last*Period;
+	return Accept;
+}
+
+// Samples of waveform inside ROI
+void MakeWave::GetROI (Double_t Period, Double_t Delay, Int_t NumSamples, Int_t &First, Int_t &Num) {
+	First = round ((fROIBegin - Delay) / Period);
+	Int_t Last = round ((fROIEnd - Delay) / Period);
+	if (First < 0)
+		First = 0;
+	if (Last > NumSamples)
+		Last = NumSamples;
+	Num = Last > First ? Last - First : 0;
+	if (First > NumSamples)
+		First = NumSamples;
 }
 
 RED::OutputFile* MakeWave::GetNewFile(const char *filename) {
-	if (fOutFile) {
-		if (fOutFile->IsOpen()) {
-			fOutFile->Close();
+	delete fWriter; // Previous file is closed
+	fNumEntries = 0;
+	fWriter = new REDWriter (filename, fWritePool);
+	if (fWriter->IsOpen()){
+		fWriter->GetRunInfo()->fDAQ_ID = "CENNS10";
+		fWriter->SetCompression (fWriteCompression);
+		fWriter->SetFlushBytes (fWriteFlushBytes);
+		if (fChannels.size()) {
+			for (unsigned int ch = 0; ch < fChannels.size(); ch++)
+				fWriter->AddWaveform (ch, fPeriod, fChannels[ch].fGain ? fChannels[ch].fGain : fGain, fNumSamples, fDelay);
 		}
-	}
-	fOutFile = new RED::OutputFile(filename);
-	fOutFile->Open();
-	if (fOutFile->IsOpen()){
-		fEvent = new RED::Event;
-		fRunInfo = new RED::RunInfo;
-		fEvent->SetRunInfo (fRunInfo);
-		fWaveform = fEvent->GetNewWaveform();
-		fWaveform->fChannel = 0;
-		fWaveform->fPeriod  = fPeriod;
-		fWaveform->fGain    = fGain;
-		fWaveform->fNumSamples = fNumSamples;
-		fWaveform->fDelay   = fDelay;
-		fEvent->fNumChannels = fEvent->GetNumWaveforms();;
-		fNumEv = 0;
-		return fOutFile;
+		else if (fOutConfigs.size()) {
+			for (unsigned int k = 0; k < fOutConfigs.size(); k++)
+				fWriter->AddWaveform (k, fOutConfigs[k].fPeriod, fOutConfigs[k].fGain, fOutConfigs[k].fNumSamples, fOutConfigs[k].fDelay);
+		}
+		else
+			fWriter->AddWaveform (0, fPeriod, fGain, fNumSamples, fDelay);
+		return fWriter->GetFile();
 	}
 	else  {
 		cout << "ERROR. File " << filename << " can't be written" << endl;
+		delete fWriter;
+		fWriter = 0;
 		return 0;
 	}
 }
 
-void MakeWave::CloseFile() {
-	if (fOutFile) {
-		if (fOutFile->IsOpen()) {
-			RED::RunInfo *info = new RED::RunInfo();
-			info->fDAQ_ID="CENNS10";
-			fOutFile->AddRunInfo(info);
-			fOutFile->Close();
-		}
+PulseWriter* MakeWave::GetNewPulseFile (const char *filename, const char *ConfigText) {
+	ClosePulseFile();
+	fNumEntries = 0;
+	fPulseFile = new PulseWriter;
+	if (!fPulseFile->Open (filename, this, ConfigText)) {
+		delete fPulseFile;
+		fPulseFile = 0;
 	}
+	return fPulseFile;
 }
 
-// Add PulseArray vector to OutWave
-void MakeWave::AddPulseArray (RED::PMT::PulseArray *Pulses) {
+FlatWaveWriter* MakeWave::GetNewFlatFile (const char *filename, Int_t SampleType) {
+	CloseFlatFile();
+	fNumEntries = 0;
+	fFlatFile = new FlatWaveWriter;
+	if (!fFlatFile->Open (filename, SampleType)) {
+		delete fFlatFile;
+		fFlatFile = 0;
+	}
+	fFlatNumEv = 0;
+	return fFlatFile;
+}
+
+void MakeWave::CloseFlatFile () {
+	if (fFlatFile) {
+		fFlatFile->Close();
+		delete fFlatFile;
+		fFlatFile = 0;
+	}
+}
+
+void MakeWave::ClosePulseFile () {
+	if (fPulseFile) {
+		fPulseFile->Close();
+		delete fPulseFile;
+		fPulseFile = 0;
+	}
+}
+
+void MakeWave::CloseFile() {
+	if (fWriter)
+		fWriter->Close(); // Pooled events are written before run info
+}
+
+// Add PulseArray vector to any waveform with PMT shape and ADC resolution Gain
+void MakeWave::AddPulseArray (const RED::PMT::PulseArray &Pulses, Double_t *OutWave, Int_t NumSamples,
+                              RED::PMT *pmt, Double_t Gain, Int_t Thread) {
 	Double_t SampleTime   = 0; // Time of sample from "0" of OutWave
 	Double_t PulseTime    = 0; // Time from "0" of OutWave to "0" of SPE shape
 	Double_t PulseAmpl    = 0; // Amplitude of SPE shape
@@ -226,23 +790,23 @@ void MakeWave::AddPulseArray (RED::PMT::PulseArray *Pulses) {
 	Int_t FinishSample    = 0; // Last sample in SPE domain
 	
 	// Go along all pulses and add them to OutWave
-	for (unsigned int i = 0; i < Pulses->size(); i++) {
+	for (unsigned int i = 0; i < Pulses.size(); i++) {
 		// Get delay time from "0" of OutWave to "0" of SPE shape
-		PulseTime    = (Pulses->at(i)).fTime - fDelay;
+		PulseTime    = Pulses[i].fTime - fDelay;
 		// Calculate left and right samples including SPE
-		StartSample  =  ceil( (PulseTime + fPMT->GetXmin()) / fPeriod );
-		FinishSample = floor( (PulseTime + fPMT->GetXmax()) / fPeriod );
+		StartSample  =  ceil( (PulseTime + pmt->GetXmin()) / fPeriod );
+		FinishSample = floor( (PulseTime + pmt->GetXmax()) / fPeriod );
 		// Get amplitude of SPE shape
-		PulseAmpl    = (Pulses->at(i)).fAmpl;
+		PulseAmpl    = Pulses[i].fAmpl;
 		// Limit edges
 		if (StartSample < 0)
 			StartSample = 0;
-		if (FinishSample > fNumSamples - 1)
-			FinishSample = fNumSamples - 1;
+		if (FinishSample > NumSamples - 1)
+			FinishSample = NumSamples - 1;
 		// Add SPE to OutWave
 		for (int s = StartSample; s <= FinishSample; s++) {
 			SampleTime = s*fPeriod;
-			fOutWave.at(s) += PulseAmpl/fGain * fPMT->Eval(SampleTime - PulseTime);
+			OutWave[s] += PulseAmpl/Gain * pmt->Eval(SampleTime - PulseTime, Thread);
 		}
 	}
-}
\ No newline at end of file
+}
@@ -2,14 +2,26 @@
 #define MakeWave_H
 
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <Rtypes.h>
+#include <TRandom3.h>
 #include "SystemOfUnits.h"
 
 #include <REDFile/File.hh>
 #include <REDEvent/Event.hh>
 
 #include "PMT_R11410.hh"
+#include "ShapeTable.h"
+#include "REDWriter.h"
+
+class PulseWriter;
+class FlatWaveWriter;
+class Trigger;
+class ElecChain;
+class WaveBatch;
 
 /////////////////////////////////////////////////////////////////////////////
 //                                                                         //
@@ -29,45 +41,135 @@ class MakeWave
 	public:
 
 		MakeWave ();
+		~MakeWave ();
 
 	// SETTERS
 		void SetPMT (RED::PMT* pmt); // Set PMT object
 		void SetOutWave (Double_t Period, Double_t Gain, Int_t NumSamples, Double_t Delay); // Set OutWave parameters
 		void SetDefaults (); // Set default OutWave parameters
 		void SetPhotonTimes (vector <double> *PhotonTimes); // Set vector of photon arrival times
-		
+		void SetPhotonTimes (const Double_t *Times, Int_t NumPhotons, const Short_t *Channels = 0); // Set photon times without copy (e.g. from PhotonFileReader),
+		                                                                                        // Channels - channel of each photon (used instead of light map)
+		void SetCompression (Bool_t Compress) {fCompress = Compress;} // Write waveforms to REDFile coded by WaveCodec (fData is a blob, see WaveCodec::Unpack)
+		void SetFilePolicy (Int_t PoolSize, Int_t Compression = -1, Long64_t FlushBytes = 0); // REDFile writing: events handed to file together,
+		                                                                                  // ROOT compression level (-1 - default), flush every FlushBytes (0 - auto)
+		void SetTrigger (Trigger *Trig) {fTrigger = Trig;} // Write only triggered events, only their ROI (0 - write everything)
+		void SetElecChain (ElecChain *Chain) {fElecChain = Chain;} // Electronics response applied to each rendered waveform (0 - none)
+
+		// Multi-channel detector (if no channels were added, single channel with fPMT is used)
+		void AddChannel (RED::PMT* pmt, Double_t TimeOffset = 0, Double_t Gain = 0); // Add channel with own PMT, time offset and ADC resolution (0 - use fGain)
+		void SetChannelPhotonTimes (Int_t ch, vector <double> *PhotonTimes); // Set photon arrival times for one channel explicitly
+		void SetLightMap (vector <double> *LightMap); // Set probabilities for photon from SetPhotonTimes to hit each channel
+		void SetNumThreads (Int_t NumThreads); // Number of threads for rendering channels (default - number of cores)
+		void SetSeed (UInt_t Seed); // Seed generators of MakeWave (light map, electronics noise of channels) for event
+
+		// Several output configurations rendered from the same SPE (written as channels 0..K-1)
+		Int_t AddOutConfig (Double_t Period, Double_t Gain, Int_t NumSamples, Double_t Delay,
+		                    RED::PMT *Shape = 0); // Add OutWave configuration (Shape - PMT with SPE shape, 0 - fPMT), return its index (-1 - error)
+		void ClearOutConfigs (); // Remove all output configurations
+
 	// GETTERS
-		vector <double> GetOutWave () {return fOutWave;} // Output waveform vector
+		const vector <double>& GetOutWave () {return fOutWave;} // Output waveform vector
+		RED::PMT* GetPMT () {return fPMT;}
+		Int_t GetNumThreads () {return fNumThreads;}
+		static UInt_t GetNoiseSeed (UInt_t Seed, Int_t ch = 0); // Seed of noise generator of channel ch set by SetSeed(Seed)
+		Long64_t GetLastEntry () {return fLastEntry;} // Entry of event added by last AddToFile in output files (-1 - rejected by trigger)
+		RED::PMT::PulseArray* GetPhotoElectrons () {return fPhotoElectrons;} // SPE caused by photons in last run
+		RED::PMT::PulseArray* GetDarkElectrons ()  {return fDarkElectrons;}  // SPE caused by dark counts in last run
 		// Get outWave parameters
 		Double_t GetPeriod ()         {return fPeriod;}      // Time between samples of OutWave
 		Double_t GetGain ()           {return fGain;}        // ADC resolution
 		Double_t GetNumSamples ()     {return fNumSamples;}  // Number of samples in OutWave
 		Double_t GetDelay ()          {return fDelay;}       // Delay from "0" of abs.time (related to photons times) to the left edge of OutWave
+		void GetPhotonWindow (Double_t &Begin, Double_t &End); // Range of photon times which may contribute to any output waveform
+		Int_t GetPhotons (const Double_t *&Times); // Photon times set by any SetPhotonTimes, return their number
 
 		// Tools for calculate F90
 		Double_t GetFrac (Double_t FracWindow = 90*ns, Double_t TotalWindow = 0); // Fraction of light in the first FracWindow of pulse (default 90*ns)
 		                                                                          // If needed, total pulse width can be limited by TotalWindow (leave 0 otherwise)
-		Int_t GetNumPE () {return fPhotoElectrons->size();} // Get number of photoelectrons emitted last run
+		Int_t GetNumPE (); // Get number of photoelectrons emitted last run (sum over all channels)
+
+		// Multi-channel getters
+		Int_t GetNumChannels ()                   {return fChannels.size();}
+		const vector <double>& GetChannelOutWave (Int_t ch) {return fChannels.at(ch).fOutWave;}
+		Int_t GetChannelNumPE (Int_t ch)          {return fChannels.at(ch).fPhotoElectrons.size();}
+
+		// Multi-configuration getters
+		Int_t GetNumOutConfigs ()                 {return fOutConfigs.size();}
+		const vector <double>& GetConfigOutWave (Int_t k) {return fOutConfigs.at(k).fOutWave;}
+
+		// Waveforms of last event without copy, as they are written to files (channels, configurations or OutWave)
+		Int_t GetNumOutWaves () {return fChannels.size() ? fChannels.size() : fOutConfigs.size() ? fOutConfigs.size() : 1;}
+		const Double_t* GetOutWaveData (Int_t k, Int_t &NumSamples, Double_t &Period, Double_t &Gain, Double_t &Delay);
+		const RED::PMT::PulseArray* GetOutWavePulses (Int_t k, Bool_t Dark = false); // SPE rendered into waveform k (photoelectrons or dark counts)
 
 		// REDFile activities
-		RED::OutputFile* GetCurrentFile () {return fOutFile;} // Return pointer to existing file
+		RED::OutputFile* GetCurrentFile () {return fWriter ? fWriter->GetFile() : 0;} // Return pointer to existing file
+		PulseWriter* GetCurrentPulseFile () {return fPulseFile;}
+		FlatWaveWriter* GetCurrentFlatFile () {return fFlatFile;}
+		Trigger* GetTrigger () {return fTrigger;}
+		ElecChain* GetElecChain () {return fElecChain;}
 		
 	// ACTIONS
 		void CreateOutWave ();   // Create OutWave
+		void CreatePulses ();    // Create only SPE (fPhotoElectrons, fDarkElectrons) without rendering OutWave
+		void CreateOutWaves ();  // Create SPE once and render them into OutWave of each output configuration
 		RED::OutputFile* GetNewFile (const char *filename); // Create new REDFile
-		void AddToFile(); // Add current fOutWave to new event in REDFile
+		PulseWriter* GetNewPulseFile (const char *filename, const char *ConfigText = 0); // Create new file for truth-level output (SPE only)
+		FlatWaveWriter* GetNewFlatFile (const char *filename, Int_t SampleType = 0); // Create new flat binary waveform file (SampleType - FlatSampleType, 2 - coded)
+		void AddToFile(); // Add current fOutWave to new event in REDFile and current SPE to pulse file (whichever is open) if trigger accepts it
+		void AddToFile(const vector <double> &OutWave); // Add any waveform to new event in REDFile and flat file (whichever is open) if trigger accepts it
+		void AddBatchToFile (const WaveBatch &Batch, vector <Long64_t> *Entries = 0); // Add all events of rendered batch (single channel only),
+		                                                                             // Entries - entry of each event in files (-1 - rejected)
+
+		// Steps of CreateOutWave working with external buffers (for running in separate threads)
+		void GenElectrons (const vector <double> &PhotonTimes, RED::PMT::PulseArray &PhotoElectrons,
+		                   RED::PMT::PulseArray &DarkElectrons); // Convert photons to SPE and generate dark counts
+		void GenElectrons (const Double_t *PhotonTimes, Int_t NumPhotons, RED::PMT::PulseArray &PhotoElectrons,
+		                   RED::PMT::PulseArray &DarkElectrons);
+		// Create waveform from SPE (NoiseRND - noise generator of thread, Thread - index of thread,
+		// see RED::PMT::SetNumThreads and ElecChain::SetNumThreads)
+		void RenderWave (const RED::PMT::PulseArray &PhotoElectrons, const RED::PMT::PulseArray &DarkElectrons,
+		                 vector <double> &OutWave, TRandom *NoiseRND = 0, Int_t Thread = 0);
+		void RenderWave (const RED::PMT::PulseArray &PhotoElectrons, const RED::PMT::PulseArray &DarkElectrons,
+		                 Double_t *OutWave, Int_t NumSamples, TRandom *NoiseRND = 0, Int_t Thread = 0);
+		Double_t GetFrac (const RED::PMT::PulseArray &Pulses, Double_t FracWindow, Double_t TotalWindow = 0); // F90 for any array of pulses
 		void CloseFile(); // Close REDFile
+		void ClosePulseFile(); // Close pulse file
+		void CloseFlatFile(); // Close flat file
 
 	// OUTPUT
 		void PrintOutWave ();    // Print OutWave (all times & amplitudes)
+		// Drawing (defined in MakeWaveDraw.cpp, library libMakeWaveDraw)
 		void DrawHists ();       // Draw some histograms
 		void DrawOutWave ();     // Draw OutWave
 		void SaveOutWave (const char *filename = "OW.root", const char *title = "OutWave"); // Save OutWave to file
 
 	private:
 		
+		// Prevent simple copy (channels own their noise generators)
+		MakeWave (const MakeWave &r);
+		MakeWave & operator= (const MakeWave &r);
+
 		// FUNCTIONS
-		void AddPulseArray (RED::PMT::PulseArray *Pulses); // Adding pulses to output waveform
+		void AddPulseArray (const RED::PMT::PulseArray &Pulses, Double_t *OutWave, Int_t NumSamples,
+		                    RED::PMT *pmt, Double_t Gain, Int_t Thread = 0); // Adding pulses to waveform with given PMT shape and gain
+		                                                                     // (Thread - rendering thread, see RED::PMT::SetNumThreads)
+		void AddPulseArray (const RED::PMT::PulseArray &Pulses, vector <double> &OutWave, RED::PMT *pmt, Double_t Gain, Int_t Thread = 0) {
+			AddPulseArray (Pulses, OutWave.size() ? &OutWave[0] : 0, OutWave.size(), pmt, Gain, Thread);
+		}
+		void CreateChannelWaves (); // Create OutWave for each channel
+		void DistributePhotons ();  // Distribute photons between channels due to their channels or fLightMap
+		void RenderChannels (Int_t First, Int_t Step); // Render channels First, First+Step, ... (one thread)
+		void ChannelWorker (Int_t First, Int_t Step, Long64_t Done); // Body of persistent rendering thread (Done - last event before start)
+		void StopWorkers ();                           // Finish and join rendering threads
+		void WriteWaves (const Double_t *OutWave, Int_t NumSamples); // Write waveforms of event to open files
+		void WriteWaves (const vector <double> &OutWave) {WriteWaves (OutWave.size() ? &OutWave[0] : 0, OutWave.size());}
+		void WriteWaveform (Int_t ch, const Double_t *Wave, Int_t NumSamples,
+		                    Double_t Period, Double_t Gain, Double_t Delay); // Write one waveform (its ROI) to open files
+		Bool_t ApplyTrigger (const Double_t *OutWave, Int_t NumSamples); // Trigger decision, sets ROI
+		Bool_t ApplyTrigger (const vector <double> &OutWave) {return ApplyTrigger (OutWave.size() ? &OutWave[0] : 0, OutWave.size());}
+		void GetROI (Double_t Period, Double_t Delay, Int_t NumSamples, Int_t &First, Int_t &Num); // ROI in samples of waveform
 
 		// VALUES
 
@@ -84,16 +186,67 @@ class MakeWave
 		RED::PMT::PulseArray *fDarkElectrons;   // array of SPE caused by dark counts
 		
 		vector <double> *fPhotonTimes; // Photons arrival times
+		const Double_t *fPhotonData;   // Photons arrival times set without copy (if fPhotonTimes is 0)
+		Int_t fNumPhotons;
+		const Short_t *fPhotonChannels; // Channels of photons from fPhotonData (0 - use light map)
+
+		// Readout channel of multi-channel detector
+		struct Channel {
+			RED::PMT *fPMT;                        // PMT object of channel
+			Double_t fTimeOffset;                  // Time offset added to photons times
+			Double_t fGain;                        // ADC resolution of channel
+			vector <double> *fPhotonTimes;         // Photons arrival times (explicit or from light map)
+			vector <double>  fMapTimes;            // Photons times distributed from light map
+			RED::PMT::PulseArray fPhotoElectrons;  // array of SPE caused by photons
+			RED::PMT::PulseArray fDarkElectrons;   // array of SPE caused by dark counts
+			vector <double> fOutWave;              // Output waveform of channel
+			TRandom3 *fNoiseRND;                   // Generator for electronics noise (channels are rendered in parallel)
+		};
+		vector <Channel> fChannels;
+		vector <double> *fLightMap; // Probabilities for photon to hit each channel
+		Int_t fNumThreads;          // Number of threads for rendering channels
+		// Persistent threads rendering channels 1..N-1 of each N (channels 0, N, ... - calling thread)
+		vector <std::thread> fWorkers;
+		std::mutex fWorkMutex;
+		std::condition_variable fWorkStart;  // New event for workers (or stop)
+		std::condition_variable fWorkDone;   // All workers finished event
+		Long64_t fWorkEvent;                 // Number of event given to workers
+		Int_t fNumBusy;                      // Workers still rendering current event
+		Bool_t fStopWorkers;
+		TRandom3 fRND;              // Object for distributing photons between channels
+
+		// Output configuration for multi-configuration rendering
+		struct OutConfig {
+			Double_t fPeriod;
+			Double_t fGain;
+			Int_t    fNumSamples;
+			Double_t fDelay;
+			ShapeTable *fShape;       // Tabulated SPE shape (shared between configurations with the same PMT)
+			vector <double> fOutWave; // Output waveform of configuration
+		};
+		vector <OutConfig> fOutConfigs;
+		vector <ShapeTable*> fShapeTables;  // Tables of SPE shapes used by fOutConfigs
+		RED::PMT::PulseArray fSortedPulses; // All SPE of event sorted by time
 
 		// Histograms
 		TH1F* fPulseAreaHist; // Area under pulse SPE (DPE)
 
 		//File
-		RED::OutputFile *fOutFile;
-		RED::Event *fEvent;
-		RED::Waveform *fWaveform;
-		RED::RunInfo *fRunInfo;
-		Int_t fNumEv;
+		REDWriter *fWriter;       // Bulk writer of REDFile (waveform ch of its events - channel/configuration ch)
+		Int_t fWritePool;         // Events written to REDFile together
+		Int_t fWriteCompression;  // ROOT compression level of REDFile (-1 - default)
+		Long64_t fWriteFlushBytes; // Flush REDFile baskets every N bytes (0 - from event size)
+		Bool_t fCompress; // Code waveforms in REDFile by WaveCodec
+		Trigger *fTrigger;                      // Software trigger (0 - write all events)
+		vector <const Double_t*> fTriggerWaves; // Waveforms of channels for trigger
+		Double_t fROIBegin;                     // ROI of triggered event (abs. time)
+		Double_t fROIEnd;
+		ElecChain *fElecChain;                  // Electronics response
+		PulseWriter *fPulseFile; // File for truth-level output
+		FlatWaveWriter *fFlatFile; // Flat binary waveform file
+		Long64_t fFlatNumEv;       // Number of events in flat file
+		Long64_t fNumEntries;      // Events accepted since output files were created (entries of REDFile, pulse and flat files)
+		Long64_t fLastEntry;       // Entry of last added event (-1 - rejected)
 };
 
 #endif // MakeWave_H
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <cstddef>
+
+#include "MakeWaveAPI.h"
+
+using std::cout;
+using std::endl;
+
+// Pulses are passed to sink as they are
+static_assert (sizeof(MWPulse) == sizeof(RED::PMT::Pulse) &&
+               offsetof(MWPulse, fAmpl) == offsetof(RED::PMT::Pulse, fAmpl) &&
+               offsetof(MWPulse, fTime) == offsetof(RED::PMT::Pulse, fTime), "MWPulse differs from RED::PMT::Pulse");
+
+static const MWPulse* PulseData (const RED::PMT::PulseArray *Pulses) {
+	return Pulses && Pulses->size() ? (const MWPulse*) &(*Pulses)[0] : 0;
+}
+
+WaveGenerator::WaveGenerator (const RunConfig &Config) {
+	fRegen    = new RunRegenerator (Config);
+	fMakeWave = fRegen->GetMakeWave();
+	fFracTime = Config.GetDouble("FracTime")*ns;
+}
+
+WaveGenerator::WaveGenerator (MakeWave *MakeWaveObj) {
+	fRegen    = 0;
+	fMakeWave = MakeWaveObj;
+	fFracTime = 90*ns;
+}
+
+WaveGenerator::~WaveGenerator () {
+	delete fRegen;
+}
+
+// With objects of run config PMT and MakeWave are seeded from seed of event,
+// so event doesn't depend on events processed before it
+Bool_t WaveGenerator::ProcessPhotons (Long64_t EventID, const Double_t *Times, Int_t NumPhotons, const Short_t *Channels) {
+	if (NumPhotons < 0 || (NumPhotons && !Times)) {
+		cout << "ERROR. Wrong photons of event " << EventID << endl;
+		return false;
+	}
+	if (fRegen) {
+		ULong64_t Seed = fRegen->GetConfig().GetEventSeed (0, EventID);
+		fMakeWave->GetPMT()->SetSeed (RunConfig::GetPMTSeed (Seed));
+		fMakeWave->SetSeed (RunConfig::GetMakeWaveSeed (Seed));
+	}
+	fMakeWave->SetPhotonTimes (Times, NumPhotons, Channels);
+	if (fMakeWave->GetNumOutConfigs())
+		fMakeWave->CreateOutWaves();
+	else
+		fMakeWave->CreateOutWave();
+	Deliver (EventID, Times, NumPhotons);
+	return true;
+}
+
+Bool_t WaveGenerator::SimulateEvent (const char *type, Long64_t EventID) {
+	if (!fRegen) {
+		cout << "ERROR. Generator was not created from run config" << endl;
+		return false;
+	}
+	if (!fRegen->RegenerateEvent (type, EventID))
+		return false;
+	const vector <double> &Times = fRegen->GetPhotonTimes();
+	Deliver (EventID, Times.size() ? &Times[0] : 0, Times.size());
+	return true;
+}
+
+// Event points to buffers of MakeWave, nothing is copied
+void WaveGenerator::Deliver (Long64_t EventID, const Double_t *Times, Int_t NumPhotons) {
+	fWaves.resize (fMakeWave->GetNumOutWaves());
+	for (unsigned int k = 0; k < fWaves.size(); k++) {
+		MWWave &Wave = fWaves[k];
+		Wave.fChannel = k;
+		Wave.fData    = fMakeWave->GetOutWaveData (k, Wave.fNumSamples, Wave.fPeriod, Wave.fGain, Wave.fDelay);
+		const RED::PMT::PulseArray *PE   = fMakeWave->GetOutWavePulses (k);
+		const RED::PMT::PulseArray *Dark = fMakeWave->GetOutWavePulses (k, true);
+		Wave.fPhotoElectrons = PulseData (PE);
+		Wave.fNumPE          = PE ? PE->size() : 0;
+		Wave.fDarkElectrons  = PulseData (Dark);
+		Wave.fNumDark        = Dark ? Dark->size() : 0;
+	}
+	fEvent.fEventID     = EventID;
+	fEvent.fPhotonTimes = Times;
+	fEvent.fNumPhotons  = NumPhotons;
+	fEvent.fNumPE       = fMakeWave->GetNumPE();
+	fEvent.fF90         = fMakeWave->GetFrac (fFracTime);
+	fEvent.fWaves       = fWaves.size() ? &fWaves[0] : 0;
+	fEvent.fNumWaves    = fWaves.size();
+	if (fSink)
+		fSink (fEvent);
+}
+
+// C INTERFACE
+
+struct MWGenerator {
+	WaveGenerator *fGen;
+};
+
+MWGenerator* MWCreate (const char *ConfigFile) {
+	RunConfig Config;
+	if (!ConfigFile || !Config.ReadFile (ConfigFile))
+		return 0;
+	MWGenerator *Gen = new MWGenerator;
+	Gen->fGen = new WaveGenerator (Config);
+	return Gen;
+}
+
+void MWDestroy (MWGenerator *Gen) {
+	if (!Gen)
+		return;
+	delete Gen->fGen;
+	delete Gen;
+}
+
+int MWSetSink (MWGenerator *Gen, MWSink Sink, void *UserData) {
+	if (!Gen)
+		return 0;
+	if (Sink)
+		Gen->fGen->SetSink ([Sink, UserData] (const MWEvent &Event) {Sink (&Event, UserData);});
+	else
+		Gen->fGen->SetSink (WaveGenerator::Sink());
+	return 1;
+}
+
+int MWSetFracTime (MWGenerator *Gen, double FracTime) {
+	if (!Gen)
+		return 0;
+	Gen->fGen->SetFracTime (FracTime*ns);
+	return 1;
+}
+
+int MWProcessPhotons (MWGenerator *Gen, long long EventID, const double *Times, int NumPhotons, const short *Channels) {
+	return Gen && Gen->fGen->ProcessPhotons (EventID, Times, NumPhotons, Channels);
+}
+
+int MWSimulateEvent (MWGenerator *Gen, const char *Type, long long EventID) {
+	return Gen && Type && Gen->fGen->SimulateEvent (Type, EventID);
+}
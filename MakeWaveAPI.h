@@ -0,0 +1,67 @@
+#ifndef MakeWaveAPI_H
+#define MakeWaveAPI_H
+
+#include <vector>
+#include <functional>
+
+#include <Rtypes.h>
+
+#include "MakeWave.h"
+#include "RunConfig.h"
+#include "RunRegenerator.h"
+#include "MakeWaveC.h"
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Embeddable waveform generation: events are rendered in memory and       //
+// handed to sink of caller instead of being written to REDFile.           //
+//                                                                         //
+// Generator either creates PMT, MakeWave and SimPhotons from run config   //
+// (as MakeWaveBatch does) or works with MakeWave of caller. Photons of    //
+// event are taken from array of caller without copy (ProcessPhotons) or   //
+// simulated from config (SimulateEvent). Sink gets MWEvent pointing to    //
+// photon times, waveforms and SPE of MakeWave itself: nothing is copied,  //
+// arrays are valid only until sink returns. The same structures are used  //
+// by C interface (MakeWaveC.h).                                           //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+class WaveGenerator
+{
+	public:
+
+		typedef std::function <void (const MWEvent &Event)> Sink;
+
+		WaveGenerator (const RunConfig &Config); // Objects of run (events are seeded by event ID)
+		WaveGenerator (MakeWave *MakeWaveObj);   // MakeWave of caller (not deleted, seeded by caller)
+		~WaveGenerator ();
+
+	// SETTERS
+		void SetSink (Sink Func) {fSink = Func;}          // Called for each event
+		void SetFracTime (Double_t FracTime) {fFracTime = FracTime;} // Window of F90 (default 90 ns)
+
+	// GETTERS
+		MakeWave* GetMakeWave () {return fMakeWave;}
+		const RunConfig* GetConfig () {return fRegen ? &fRegen->GetConfig() : 0;} // Config of run (0 for MakeWave of caller)
+		const MWEvent& GetEvent () {return fEvent;} // Last event (valid until next one)
+
+	// ACTIONS
+		Bool_t ProcessPhotons (Long64_t EventID, const Double_t *Times, Int_t NumPhotons,
+		                       const Short_t *Channels = 0); // Render event from photons (Channels - channel of each photon)
+		Bool_t SimulateEvent (const char *type, Long64_t EventID); // Event of run config (the same as in MakeWaveBatch)
+
+	private:
+
+		void Deliver (Long64_t EventID, const Double_t *Times, Int_t NumPhotons); // Fill fEvent and call sink
+
+		RunRegenerator *fRegen;  // Objects of run config (0 for MakeWave of caller)
+		MakeWave *fMakeWave;
+		Double_t fFracTime;
+		Sink fSink;
+		MWEvent fEvent;
+		vector <MWWave> fWaves;
+};
+
+#endif // MakeWaveAPI_H
@@ -0,0 +1,67 @@
+#ifndef MakeWaveC_H
+#define MakeWaveC_H
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// C interface of embeddable waveform generation (see MakeWaveAPI.h).      //
+//                                                                         //
+// Generator is created from run config file, photons of event are given   //
+// as array of times (MWProcessPhotons) or simulated from config           //
+// (MWSimulateEvent), finished event is passed to sink set by MWSetSink.   //
+// All arrays of MWEvent belong to generator: they are valid only inside   //
+// sink call and must be copied if needed later.                           //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SPE pulse (the same layout as RED::PMT::Pulse)
+typedef struct MWPulse {
+	double fAmpl;
+	double fTime;
+} MWPulse;
+
+// Output waveform of event (channel or output configuration, as written to REDFile)
+typedef struct MWWave {
+	int           fChannel;
+	const double *fData;           // Samples
+	int           fNumSamples;
+	double        fPeriod;         // Time between samples
+	double        fGain;           // ADC resolution
+	double        fDelay;          // Time of the first sample
+	const MWPulse *fPhotoElectrons; // SPE rendered into waveform
+	int           fNumPE;
+	const MWPulse *fDarkElectrons;
+	int           fNumDark;
+} MWWave;
+
+typedef struct MWEvent {
+	long long     fEventID;
+	const double *fPhotonTimes;
+	int           fNumPhotons;
+	int           fNumPE;          // Sum over all channels
+	double        fF90;            // Fraction of light in the first FracTime of pulse
+	const MWWave *fWaves;
+	int           fNumWaves;
+} MWEvent;
+
+typedef void (*MWSink) (const MWEvent *Event, void *UserData);
+typedef struct MWGenerator MWGenerator;
+
+MWGenerator* MWCreate (const char *ConfigFile);   // Generator with objects of run config (0 on error)
+void MWDestroy (MWGenerator *Gen);
+// Setters return 0 on error (Gen is 0, e.g. MWCreate failed)
+int MWSetSink (MWGenerator *Gen, MWSink Sink, void *UserData);
+int MWSetFracTime (MWGenerator *Gen, double FracTime); // Window of F90 (ns)
+// Render event from photon times (Channels - channel of each photon or 0), return 0 on error (also if Gen is 0)
+int MWProcessPhotons (MWGenerator *Gen, long long EventID, const double *Times, int NumPhotons, const short *Channels);
+// Simulate event of run config by its type and ID (the same as MakeWaveBatch), return 0 on error
+int MWSimulateEvent (MWGenerator *Gen, const char *Type, long long EventID);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MakeWaveC_H
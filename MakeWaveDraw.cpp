@@ -0,0 +1,90 @@
+#include <TCanvas.h>
+#include <TH1.h>
+#include <TGraph.h>
+
+#include "MakeWave.h"
+#include "MakeTest.h"
+
+// Drawing methods of MakeWave and MakeTest. They are kept out of the core
+// library (libMakeWaveCore), so batch programs don't need ROOT graphics
+
+// Draw histograms
+void MakeWave::DrawHists() {
+
+	// For pulse area
+	if (!fPulseAreaHist) {
+		Double_t Low_Area  = 0;
+		Double_t High_Area = 3*fPMT->GetArea()/(ns*mV);
+		fPulseAreaHist  = new TH1F ("fPulseAreaHist","PulseArea[mV*ns]",1000, Low_Area, High_Area);
+	}
+	for (unsigned int i=0; i< fPhotoElectrons->size(); i++) {
+		RED::PMT::Pulse OnePulse = (*fPhotoElectrons).at(i);
+		fPulseAreaHist->Fill (OnePulse.fAmpl * fPMT->GetShapeArea() / (mV*ns));
+	}
+	TCanvas *c3 = new TCanvas();
+	c3->SetTitle("Pulse Area");
+	c3->cd();
+	c3->SetLogy();
+	fPulseAreaHist->Draw();
+}
+
+// Draw OutWave
+void MakeWave::DrawOutWave () {
+	TCanvas *c1 = new TCanvas();
+	c1->cd();
+	TGraph  *g1 = new TGraph(fNumSamples);
+	for (int i = 0; i < fNumSamples; i++) {
+		g1->SetPoint(i, (fDelay + i*fPeriod)/ns, fOutWave.at(i));
+	}
+	g1->SetTitle("Waveform");
+	g1->Draw();
+}
+
+void MakeWave::SaveOutWave (const char *filename, const char *title) {
+	TCanvas *c1 = new TCanvas();
+	c1->cd();
+	TGraph  *g1 = new TGraph(fNumSamples);
+	for (int i = 0; i < fNumSamples; i++) {
+		g1->SetPoint(i, (fDelay + i*fPeriod)/ns, fOutWave.at(i));
+	}
+	g1->SetTitle(title);
+	g1->SaveAs(filename);
+}
+
+void MakeTest::DrawOW (MakeWave* MakeWaveObj) {
+	Double_t Period     = MakeWaveObj -> GetPeriod();
+	//Double_t Gain       = MakeWaveObj -> GetGain();
+	Double_t NumSamples = MakeWaveObj -> GetNumSamples();
+	Double_t Delay      = MakeWaveObj -> GetDelay();
+
+	TCanvas *c3 = new TCanvas();
+	c3->cd();
+	c3->SetTitle("OutWave");
+	TGraph *g2  = new TGraph (NumSamples);
+	for (int i = 0; i < NumSamples; i++){
+		g2->SetPoint (i, (Delay + i*Period)/ns, (*fMeanOutWave)[i]);
+		// cout << "point num " << i << "at time= " << (Delay + i*Period)/ns << " ns ";
+		// cout << "with ampl= " << (*fMeanOutWave)[i] << " ADC-units was added" <<endl;
+	}
+	g2->SetTitle("OutWave;Time, ns;Amplitude, ADC units");
+	g2->Draw();
+}
+
+void MakeTest::DrawShape (RED::PMT *pmt, Char_t const *title) {
+	TCanvas *c5 = new TCanvas();
+	c5->SetTitle("SPE Shape");
+	c5->cd();
+	switch (pmt->fMode) {
+		case RED::PMT::kModeNone :
+			break;
+		case RED::PMT::kModeF1 :
+			pmt->fShape.func->SetTitle (title);
+			pmt->fShape.func->Draw();
+			break;
+		case RED::PMT::kModeSpline :
+			pmt->fShape.spline->SetTitle (title);
+			pmt->fShape.spline->Draw();
+			break;
+	}
+	//c5->WaitPrimitive();
+}
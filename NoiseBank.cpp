@@ -0,0 +1,216 @@
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "NoiseBank.h"
+
+using std::cout;
+using std::endl;
+using std::complex;
+
+static const char kCacheMagic[8] = {'M','W','N','O','I','S','E','1'};
+
+NoiseBank::NoiseBank () {
+	fPeriod = 0;
+	fRMS    = 0;
+	SetSeed (1);
+}
+
+void NoiseBank::SetPSD (const vector <double> &Freq, const vector <double> &PSD) {
+	if (Freq.size() != PSD.size() || Freq.size() < 2) {
+		cout << "ERROR. PSD must have the same number (at least 2) of frequencies and densities" << endl;
+		return;
+	}
+	fFreq = Freq;
+	fPSD  = PSD;
+}
+
+Double_t NoiseBank::EvalPSD (Double_t Freq) {
+	if (fFreq.empty() || Freq < fFreq.front() || Freq > fFreq.back())
+		return 0;
+	unsigned int i = std::upper_bound (fFreq.begin(), fFreq.end(), Freq) - fFreq.begin();
+	if (i >= fFreq.size())
+		return fPSD.back();
+	Double_t frac = (Freq - fFreq[i-1]) / (fFreq[i] - fFreq[i-1]);
+	return fPSD[i-1] + frac * (fPSD[i] - fPSD[i-1]);
+}
+
+// Iterative radix-2 FFT without normalization
+void NoiseBank::FFT (vector <complex <double> > &Data, Bool_t Inverse) {
+	const unsigned int n = Data.size();
+	// Bit reversal permutation
+	for (unsigned int i = 1, j = 0; i < n; i++) {
+		unsigned int bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap (Data[i], Data[j]);
+	}
+	for (unsigned int len = 2; len <= n; len <<= 1) {
+		Double_t angle = 2 * M_PI / len * (Inverse ? 1 : -1);
+		complex <double> wlen (cos(angle), sin(angle));
+		for (unsigned int i = 0; i < n; i += len) {
+			complex <double> w (1, 0);
+			for (unsigned int k = 0; k < len/2; k++) {
+				complex <double> u = Data[i + k];
+				complex <double> v = Data[i + k + len/2] * w;
+				Data[i + k]         = u + v;
+				Data[i + k + len/2] = u - v;
+				w *= wlen;
+			}
+		}
+	}
+}
+
+Bool_t NoiseBank::Generate (Double_t Period, Int_t LogSize) {
+	if (fFreq.empty()) {
+		cout << "ERROR. Noise PSD was not set" << endl;
+		return false;
+	}
+	const Int_t Size = 1 << LogSize;
+	Double_t df = 1 / (Size * Period / (1e9*ns)); // Frequency step, Hz
+
+	// Random spectrum with amplitudes sqrt(PSD), variance = integral of PSD
+	vector <complex <double> > Spectrum (Size);
+	Double_t Variance = 0;
+	for (Int_t k = 1; k < Size; k++) {
+		Double_t Freq = (k <= Size/2 ? k : Size - k) * df;
+		Double_t Ampl = sqrt (EvalPSD (Freq));
+		Spectrum[k] = complex <double> (Ampl * fRND.Gaus(), Ampl * fRND.Gaus());
+		if (k <= Size/2)
+			Variance += EvalPSD (Freq) * df;
+	}
+	FFT (Spectrum, true);
+
+	// Real part is a realization of noise, normalize it to the PSD integral
+	Double_t Sum2 = 0;
+	for (Int_t i = 0; i < Size; i++)
+		Sum2 += Spectrum[i].real() * Spectrum[i].real();
+	Double_t Scale = Sum2 > 0 ? sqrt (Variance * Size / Sum2) : 0;
+	fBank.resize (Size);
+	for (Int_t i = 0; i < Size; i++)
+		fBank[i] = Spectrum[i].real() * Scale;
+	fPeriod = Period;
+	fRMS    = sqrt (Variance);
+	return true;
+}
+
+// FNV-1a hash of PSD and bank parameters
+ULong64_t NoiseBank::GetKey (Double_t Period, Int_t LogSize) {
+	ULong64_t Hash = 0xCBF29CE484222325ULL;
+	vector <double> Values (fFreq);
+	Values.insert (Values.end(), fPSD.begin(), fPSD.end());
+	Values.push_back (Period);
+	Values.push_back (LogSize);
+	Values.push_back (fSeed);
+	const UChar_t *bytes = (const UChar_t*) &Values[0];
+	for (size_t i = 0; i < Values.size() * sizeof(double); i++) {
+		Hash ^= bytes[i];
+		Hash *= 0x100000001B3ULL;
+	}
+	return Hash;
+}
+
+Bool_t NoiseBank::Save (const char *filename) {
+	std::ofstream file (filename, std::ios::binary);
+	if (!file) {
+		cout << "ERROR. File " << filename << " can't be written" << endl;
+		return false;
+	}
+	Int_t LogSize = log2 (fBank.size());
+	ULong64_t Key = GetKey (fPeriod, LogSize);
+	ULong64_t Size = fBank.size();
+	file.write (kCacheMagic, sizeof(kCacheMagic));
+	file.write ((const char*) &Key,  sizeof(Key));
+	file.write ((const char*) &Size, sizeof(Size));
+	file.write ((const char*) &fRMS, sizeof(fRMS));
+	file.write ((const char*) &fBank[0], Size * sizeof(Float_t));
+	return file.good();
+}
+
+Bool_t NoiseBank::Load (const char *filename, Double_t Period, Int_t LogSize) {
+	std::ifstream file (filename, std::ios::binary);
+	if (!file)
+		return false;
+	char Magic[8];
+	ULong64_t Key, Size;
+	Double_t RMS;
+	file.read (Magic, sizeof(Magic));
+	file.read ((char*) &Key,  sizeof(Key));
+	file.read ((char*) &Size, sizeof(Size));
+	file.read ((char*) &RMS,  sizeof(RMS));
+	if (!file || memcmp (Magic, kCacheMagic, sizeof(Magic)) || Key != GetKey (Period, LogSize) || Size != (1ULL << LogSize))
+		return false;
+	fBank.resize (Size);
+	file.read ((char*) &fBank[0], Size * sizeof(Float_t));
+	if (!file) {
+		fBank.clear();
+		return false;
+	}
+	fPeriod = Period;
+	fRMS    = RMS;
+	return true;
+}
+
+Bool_t NoiseBank::Init (Double_t Period, Int_t LogSize, const char *CacheFile) {
+	if (CacheFile && Load (CacheFile, Period, LogSize)) {
+		cout << "Noise bank was loaded from " << CacheFile << endl;
+		return true;
+	}
+	if (!Generate (Period, LogSize))
+		return false;
+	if (CacheFile)
+		Save (CacheFile);
+	return true;
+}
+
+// Bank and its RMS are two tables of cache
+Bool_t NoiseBank::Init (Double_t Period, Int_t LogSize, PrecompCache *Cache) {
+	ULong64_t Key = GetKey (Period, LogSize);
+	ULong64_t RMSKey = CacheKey (Key).Add ("NoiseRMS").Get();
+	vector <double> RMS;
+	if (Cache && Cache->Get (RMSKey, RMS, 1) && Cache->Get (Key, fBank, 1ULL << LogSize)) {
+		fPeriod = Period;
+		fRMS    = RMS[0];
+		return true;
+	}
+	if (!Generate (Period, LogSize))
+		return false;
+	if (Cache) {
+		Cache->Add (Key, fBank);
+		Cache->Add (RMSKey, vector <double> (1, fRMS));
+	}
+	return true;
+}
+
+Int_t NoiseBank::GetRandomOffset (TRandom *RND) {
+	if (!RND)
+		RND = &fRND;
+	return RND->Rndm() * fBank.size();
+}
+
+void NoiseBank::AddTo (Double_t *Wave, Int_t NumSamples, TRandom *RND) {
+	AddTo (Wave, NumSamples, GetRandomOffset (RND));
+}
+
+void NoiseBank::AddTo (Double_t *Wave, Int_t NumSamples, Int_t Offset) {
+	const Int_t Size = fBank.size();
+	if (!Size)
+		return;
+	const Float_t *Bank = &fBank[0];
+	Int_t i = 0;
+	while (i < NumSamples) {
+		// Contiguous part up to the end of bank
+		Offset %= Size;
+		Int_t n = std::min (NumSamples - i, Size - Offset);
+		const Float_t *src = Bank + Offset;
+		Double_t *dst = Wave + i;
+		for (Int_t k = 0; k < n; k++)
+			dst[k] += src[k];
+		i += n;
+		Offset += n;
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef NoiseBank_H
+#define NoiseBank_H
+
+#include <vector>
+#include <complex>
+
+#include <Rtypes.h>
+#include <TRandom3.h>
+#include "SystemOfUnits.h"
+#include "PrecompCache.h"
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Bank of correlated electronic noise with given power spectral density.  //
+// PSD is set by points (frequency in Hz, one-sided density in ADC^2/Hz),  //
+// linearly interpolated (as measured in pedestal runs).                   //
+//                                                                         //
+// Bank of 2^LogSize samples is generated once by inverse FFT of random    //
+// spectrum with amplitudes sqrt(PSD) and normalized to the RMS given by   //
+// PSD integral. FFT noise is periodic, so window starting at any sample   //
+// of bank (wrapped around its end) is a valid noise realization: adding   //
+// noise to event costs only a copy-add from the bank.                     //
+//                                                                         //
+// Bank may be saved to cache file and loaded at next start, if PSD,       //
+// sampling period, size and seed are the same (own file or PrecompCache). //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+using CLHEP::ns;
+
+class NoiseBank
+{
+	public:
+
+		NoiseBank ();
+
+	// SETTERS
+		void SetPSD (const vector <double> &Freq, const vector <double> &PSD); // Frequencies (Hz) and PSD (ADC^2/Hz)
+		void SetSeed (UInt_t Seed) {fSeed = Seed; fRND.SetSeed(Seed);}
+
+	// GETTERS
+		Double_t GetPeriod ()  {return fPeriod;}
+		Int_t    GetSize ()    {return fBank.size();}
+		Double_t GetRMS ()     {return fRMS;}
+		const Float_t* GetData () {return fBank.size() ? &fBank[0] : 0;}
+		Double_t EvalPSD (Double_t Freq); // Interpolated PSD at Freq (Hz)
+
+	// ACTIONS
+		Bool_t Generate (Double_t Period, Int_t LogSize = 20);       // Generate bank for sampling Period
+		Bool_t Init (Double_t Period, Int_t LogSize, const char *CacheFile); // Load bank from cache or generate and save it
+		Bool_t Init (Double_t Period, Int_t LogSize, PrecompCache *Cache);   // The same with shared cache of precomputed tables
+		Bool_t Save (const char *filename);
+		Bool_t Load (const char *filename, Double_t Period, Int_t LogSize); // Load bank if it matches parameters
+		Int_t GetRandomOffset (TRandom *RND = 0); // Random start of window in bank
+		void AddTo (Double_t *Wave, Int_t NumSamples, TRandom *RND = 0); // Add random window of bank to waveform
+		void AddTo (Double_t *Wave, Int_t NumSamples, Int_t Offset);    // Add window starting at Offset
+
+		static void FFT (vector <std::complex <double> > &Data, Bool_t Inverse); // In-place radix-2 FFT (size is power of 2)
+
+	private:
+
+		ULong64_t GetKey (Double_t Period, Int_t LogSize); // Hash of parameters of bank
+
+		vector <double> fFreq;
+		vector <double> fPSD;
+		vector <Float_t> fBank;
+		Double_t fPeriod;
+		Double_t fRMS;
+		UInt_t fSeed;
+		TRandom3 fRND;
+};
+
+#endif // NoiseBank_H
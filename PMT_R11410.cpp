@@ -1,7 +1,7 @@
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
-#include <TCanvas.h>
 #include <TMath.h>
 
 #include "PMT_R11410.hh"
@@ -13,6 +13,8 @@ namespace RED
 {
 	PMT_R11410::PMT_R11410() {
 		fRND.SetSeed(0);
+		fCache    = 0;
+		fModelKey = 0;
 		fShape.func   = 0;
 		fSPEAreaPdf = new TF1 ("pdf for SPE Area","ROOT::Math::gaussian_pdf(x,[0],[1])",0*ns,500*mV*ns);
 		fSPEAreaPdf->SetParameter(0,1*mV*ns);
@@ -20,6 +22,10 @@ namespace RED
 		//cout << "PMT_R11410 object was created" << endl;
 	}
 
+	PMT_R11410::~PMT_R11410() {
+		ClearShapeCopies();
+	}
+
 	// Set PMT Hamamatsu R11410-20 parameters.
 	// Some values are taken from articles C.H.Faham et.al. "Measurements of wavelength-dependent
 	// double photoelectron emission..." //JINST 2015 and D.Yu.Akimov et.al. "Performance of
@@ -42,6 +48,7 @@ namespace RED
 		fAP_peak    = 0;         // Afterpulsing probability
 		
 		// Set shape as gaussian
+		ClearShapeCopies();
 		fMode     = kModeF1;
 		fShape.func = new TF1("SPE","gaus(0)",-5*ns,5*ns);
 		fShape.func->SetParameter(0, 1*mV); // Amplitude of gaussian (1 mV)
@@ -76,7 +83,13 @@ namespace RED
 		fArea_1d_sigma  = fArea_sigma / fGain_PC_1d;
 
 		// Get shape area and amplitude from SPE area
-		switch (fMode) {
+		ULong64_t AreaKey = CacheKey (fModelKey).Add ("ShapeArea").Get();
+		std::vector<Double_t> Cached;
+		if (fCache && fCache->Get (AreaKey, Cached, 1)) {
+			fShapeArea = Cached[0];
+			fAmpl_mean = fArea_mean / fShapeArea;
+		}
+		else switch (fMode) {
 			case kModeF1 :
 				fShapeArea = fShape.func->Integral(GetXmin (), GetXmax ());
 				fAmpl_mean = fArea_mean / fShapeArea;
@@ -89,11 +102,16 @@ namespace RED
 				fAmpl_mean = 0;
 				break;
 		}
+		if (fCache && !Cached.size() && fMode != kModeNone)
+			fCache->Add (AreaKey, std::vector<Double_t> (1, fShapeArea));
 		fAmpl_sigma    = fAmpl_mean * (fArea_sigma/fArea_mean) ;
 
 		// Get TOF(e-) from 1d to Anode
 		fTOFe_1d_mean   = fTOFe_mean - fTOFe_PC_1d;
 		fTOFe_1d_sigma  = 0.5 * fTOFe_sigma; // May be wrong
+
+		// Tabulate SPE area distribution
+		FillAreaCDF (1000);
 		
 		cout << "Additional PMT parameters were calculated" << endl;
 	}
@@ -112,6 +130,33 @@ namespace RED
 		}
 	}
 
+	// Thread 0 evaluates shape itself, the other threads - its copies.
+	// TSpline::Eval has no state, spline is shared by all threads
+	Double_t PMT_R11410::Eval (Double_t t, Int_t Thread) const {
+		if (fMode == kModeF1 && Thread > 0 && Thread <= (Int_t) fShapeCopies.size())
+			return fShapeCopies[Thread-1]->Eval(t);
+		return Eval(t);
+	}
+
+	void PMT_R11410::SetNumThreads (Int_t NumThreads) {
+		if (fMode != kModeF1 || !fShape.func)
+			return;
+		while ((Int_t) fShapeCopies.size() < NumThreads - 1) {
+			TF1 *Copy = (TF1*) fShape.func->Clone();
+			if (!Copy) {
+				cout << "ERROR. SPE shape can't be copied for rendering threads" << endl;
+				return;
+			}
+			fShapeCopies.push_back (Copy);
+		}
+	}
+
+	void PMT_R11410::ClearShapeCopies () {
+		for (unsigned int i = 0; i < fShapeCopies.size(); i++)
+			delete fShapeCopies[i];
+		fShapeCopies.clear();
+	}
+
 	Double_t PMT_R11410::SplineIntegral (TSpline* spline, Double_t xmin, Double_t xmax, Int_t nbins) {
 		Double_t Integral = 0;
 		Double_t BinWidth = (xmax - xmin) / nbins;
@@ -122,6 +167,54 @@ namespace RED
 		return Integral;
 	}
 
+	// Cached table is {AreaMin, AreaStep, CDF}
+	void PMT_R11410::FillAreaCDF (Int_t nbins) {
+		ULong64_t CDFKey = CacheKey (fModelKey).Add ("AreaCDF").Add (nbins).Get();
+		if (fCache && fCache->Get (CDFKey, fAreaCDF, nbins + 3)) {
+			fAreaMin  = fAreaCDF[0];
+			fAreaStep = fAreaCDF[1];
+			fAreaCDF.erase (fAreaCDF.begin(), fAreaCDF.begin() + 2);
+			return;
+		}
+		fAreaMin  = fSPEAreaPdf->GetXmin();
+		fAreaStep = (fSPEAreaPdf->GetXmax() - fAreaMin) / nbins;
+		fAreaCDF.resize (nbins + 1);
+		fAreaCDF[0] = 0;
+		for (int i = 0; i < nbins; i++) {
+			Double_t pdf = fSPEAreaPdf->Eval(fAreaMin + (i+0.5)*fAreaStep);
+			if (pdf < 0)
+				pdf = 0;
+			fAreaCDF[i+1] = fAreaCDF[i] + pdf;
+		}
+		if (fAreaCDF[nbins] <= 0) {
+			cout << "ERROR. SPE area pdf is not positive" << endl;
+			fAreaCDF.clear();
+			return;
+		}
+		for (int i = 1; i <= nbins; i++)
+			fAreaCDF[i] /= fAreaCDF[nbins];
+		if (fCache) {
+			std::vector<Double_t> Table (fAreaCDF);
+			Table.insert (Table.begin(), fAreaStep);
+			Table.insert (Table.begin(), fAreaMin);
+			fCache->Add (CDFKey, Table);
+		}
+	}
+
+	Double_t PMT_R11410::AreaFromUniform (Double_t RND) {
+		if (!fAreaCDF.size())
+			return fSPEAreaPdf->GetRandom();
+		// Find bin and interpolate linearly inside it
+		Int_t bin = std::upper_bound (fAreaCDF.begin(), fAreaCDF.end(), RND) - fAreaCDF.begin() - 1;
+		if (bin < 0)
+			bin = 0;
+		if (bin > (Int_t) fAreaCDF.size() - 2)
+			bin = fAreaCDF.size() - 2;
+		Double_t dCDF = fAreaCDF[bin+1] - fAreaCDF[bin];
+		Double_t frac = dCDF > 0 ? (RND - fAreaCDF[bin]) / dCDF : 0.5;
+		return fAreaMin + (bin + frac) * fAreaStep;
+	}
+
 	int PMT_R11410::Begin(PulseArray &electrons) {
 		cout << "Function 'Begin' is not yet implemented" << endl;
 		return(0);
@@ -185,7 +278,7 @@ namespace RED
 
 		// Simulate time & ampl of spe , fill hists
 		for (int i = 0; i < abs(NumPhe); i++) {
-			OnePulse.fAmpl = fSPEAreaPdf->GetRandom() / GetShapeArea();
+			OnePulse.fAmpl = GetRandomArea() / GetShapeArea();
 			//OnePulse.fAmpl = fRND.Gaus (AmplMean, AmplSigma);
 			TOFe           = fRND.Gaus (TOFeMean, TOFeSigma);
 			OnePulse.fTime = TOFe + time;
@@ -195,12 +288,69 @@ namespace RED
 		return NumPhe;
 	}
 
+	// Same as OnePhoton for each photon, but with random numbers drawn in batches:
+	// interaction types first, then areas and times of flight of all phe
+	void PMT_R11410::ManyPhotons (const Double_t *times, Int_t n, PulseArray& electrons, Double_t Offset) {
+		if (n <= 0)
+			return;
+		if ((Int_t) fBufU.size() < n)
+			fBufU.resize (n);
+		fRND.FillUniform (&fBufU[0], n);
+
+		// Interaction types (bands of OnePhoton) without branches: number of
+		// band edges above RND selects number of phe, it's kept in place of RND
+		static const Int_t Types[5] = {0, -2, -1, 2, 1};
+		const Double_t Edge1 = fProb_C1, Edge2 = fProb_C, Edge3 = fProb_C + fProb_1d1, Edge4 = fProb_C + fProb_1d;
+		Int_t NumPhe = 0;
+		for (Int_t i = 0; i < n; i++) {
+			Double_t RND = fBufU[i];
+			Int_t Type = Types[(RND < Edge1) + (RND < Edge2) + (RND < Edge3) + (RND <= Edge4)];
+			fBufU[i] = Type;
+			NumPhe += abs (Type);
+		}
+		if (!NumPhe)
+			return;
+
+		if ((Int_t) fBufA.size() < NumPhe) {
+			fBufA.resize (NumPhe);
+			fBufG.resize (NumPhe);
+		}
+		fRND.FillUniform (&fBufA[0], NumPhe);
+		fRND.FillGaus    (&fBufG[0], NumPhe);
+		Double_t ShapeArea = GetShapeArea();
+		Pulse OnePulse;
+		Int_t k = 0;
+		electrons.reserve (electrons.size() + NumPhe);
+		for (Int_t i = 0; i < n; i++) {
+			Int_t Type = fBufU[i];
+			if (!Type)
+				continue;
+			Double_t TOFeMean  = Type > 0 ? fTOFe_mean  : fTOFe_1d_mean;
+			Double_t TOFeSigma = Type > 0 ? fTOFe_sigma : fTOFe_1d_sigma;
+			for (Int_t j = 0; j < abs(Type); j++, k++) {
+				OnePulse.fAmpl = AreaFromUniform (fBufA[k]) / ShapeArea;
+				OnePulse.fTime = TOFeMean + TOFeSigma * fBufG[k] + times[i] + Offset;
+				electrons.push_back (OnePulse);
+			}
+		}
+	}
+
 	void PMT_R11410::GenDCR (Double_t begintime, Double_t endtime, PulseArray& darkelectrons) {
-		unsigned int DarkNum = fRND.Poisson (fDCR * (endtime - begintime)); // Number of dark counts
+		Int_t DarkNum = fRND.Poisson (fDCR * (endtime - begintime)); // Number of dark counts
+		if (!DarkNum)
+			return;
+		if ((Int_t) fBufA.size() < DarkNum) {
+			fBufA.resize (DarkNum);
+			fBufG.resize (DarkNum);
+		}
+		fRND.FillUniform (&fBufA[0], DarkNum); // Areas
+		fRND.FillUniform (&fBufG[0], DarkNum); // Times
+		Double_t ShapeArea = GetShapeArea();
 		Pulse DarkPulse;     // Temporary variable for saving each SPE
-		for (unsigned int i = 0; i < DarkNum; i++) {
-			DarkPulse.fAmpl = fSPEAreaPdf->GetRandom() / GetShapeArea();
-			DarkPulse.fTime = fRND.Rndm() * (endtime - begintime) + begintime;
+		darkelectrons.reserve (darkelectrons.size() + DarkNum);
+		for (Int_t i = 0; i < DarkNum; i++) {
+			DarkPulse.fAmpl = AreaFromUniform (fBufA[i]) / ShapeArea;
+			DarkPulse.fTime = fBufG[i] * (endtime - begintime) + begintime;
 			darkelectrons.push_back (DarkPulse);
 		}
 		//cout << "It were generated " << DarkNum << " dark counts between " << begintime/ns << " ns and " << endtime/ns << "ns" << endl;
@@ -379,6 +529,15 @@ namespace RED
 			}
 	}
 	
+	// ToF is gaussian, probability to be out of 8 sigma is ~1e-15
+	Double_t PMT_R11410::GetDelayMin () const {
+		return std::min (fTOFe_mean - 8*fTOFe_sigma, fTOFe_1d_mean - 8*fTOFe_1d_sigma);
+	}
+
+	Double_t PMT_R11410::GetDelayMax () const {
+		return std::max (fTOFe_mean + 8*fTOFe_sigma, fTOFe_1d_mean + 8*fTOFe_1d_sigma);
+	}
+	
 	void PMT_R11410::SetParams (double QE, double Area_mean, double DCR, double AP_cont) {
 		fQE         = QE;
 		fArea_mean  = Area_mean;
@@ -442,16 +601,19 @@ namespace RED
 
 	void PMT_R11410::SetPdfAreaSPE (TF1 *SPEAreaPdf) {
 		fSPEAreaPdf = SPEAreaPdf;
+		fAreaCDF.clear(); // Will be tabulated again by CalculateParams
 		cout << "set SPE Area PDF" << endl;
 	}
 
 	void PMT_R11410::SetShape (TF1* Shape) {
+		ClearShapeCopies();
 		fMode = kModeF1;
 		fShape.func   = Shape;
 		cout << "set PMT Shape as TF1" << endl;
 	}
 
 	void PMT_R11410::SetShape (TSpline* Shape) {
+		ClearShapeCopies();
 		fMode = kModeSpline;
 		fShape.spline   = Shape;
 		cout << "set PMT Shape as TSpline" << endl;
@@ -2,9 +2,11 @@
 #define PMT_R11410_HH
 #include <TF1.h>
 #include <TSpline.h>
-#include <TRandom3.h>
 #include "SystemOfUnits.h"
 
+#include "BulkRNG.h"
+#include "PrecompCache.h"
+
 //////////////////////////////////////////////////////////////////////////
 //                                                                      //
 // RED::PMT                                                             //
@@ -43,7 +45,7 @@ namespace RED
 	{
 		public:
 		
-			PMT() { ; }
+			PMT() : fMode (kModeNone) { fShape.func = 0; } // No SPE shape until SetShape
 			virtual ~PMT() { ; }
 			//virtual TObject* Clone(const char *newname="") const = 0;
 			
@@ -74,6 +76,8 @@ namespace RED
 			virtual void SetShape (TF1     *Shape) = 0; // SPE shape in function form
 			virtual void SetShape (TSpline *Shape) = 0; // SPE shape in spline form
 			virtual void SetPdfAreaSPE (TF1 *SPEAreaPdf) = 0;
+			virtual void SetSeed (UInt_t Seed) { ; } // Seed of random generator (0 - random seed)
+			virtual void SetNumThreads (Int_t NumThreads) { ; } // Prepare Eval(t, Thread) for threads 0..NumThreads-1 (call before starting them)
 
 		// GETTERS
 			virtual Double_t GetXmax()         const = 0; // Right point of the domain of definition
@@ -82,13 +86,22 @@ namespace RED
 			virtual Double_t GetYmin()         const = 0; // Minimum value of SPE Shape
 			virtual Double_t GetArea()         const = 0; // Pulse area of SPE
 			virtual Double_t Eval (Double_t t) const = 0; // Value of SPE Shape at time t
+			virtual Double_t Eval (Double_t t, Int_t Thread) const { return Eval (t); } // The same from rendering thread Thread (see SetNumThreads)
 			virtual Double_t GetShapeArea()    const = 0; // Pulse area of SPE Shape
 			virtual Double_t GetAmpl()         const = 0;
 			virtual Double_t GetAmpl_Sigma()   const = 0;
+			virtual Double_t GetDelayMin()     const { return 0; } // Minimum delay of SPE after photon arrival
+			virtual Double_t GetDelayMax()     const { return 0; } // Maximum delay of SPE after photon arrival
+			virtual PrecompCache* GetCache()   const { return 0; } // Cache for tables derived from PMT model (0 - none)
+			virtual ULong64_t GetModelKey()    const { return 0; } // Hash of all parameters of PMT model
 
 		// ACTIONS
 			virtual int  Begin     (PulseArray &electrons) { return(0); }
 			virtual Char_t OnePhoton (Double_t time, PulseArray &Pulse, bool fDebug = false) = 0; // Convert photons to pulses
+			virtual void ManyPhotons (const Double_t *times, Int_t n, PulseArray &Pulse, Double_t Offset = 0) { // Convert n photons (arrived at times + Offset)
+				for (Int_t i = 0; i < n; i++)
+					OnePhoton (times[i] + Offset, Pulse, false);
+			}
 			virtual int  End       (PulseArray &electrons) { return(0); }
 			virtual void Clear     (Option_t *option="") { ; }
 			virtual void GenDCR    (Double_t begintime, Double_t endtime, PulseArray& DarkPulse) { ; } // Generate pulses for dark counts
@@ -111,7 +124,7 @@ namespace RED
 		public:
 		
 			 PMT_R11410();
-			~PMT_R11410() {;}
+			~PMT_R11410();
 			virtual TObject* Clone (const char *newname="") const { return 0;}
 			
 		// SETTERS
@@ -133,6 +146,13 @@ namespace RED
 			void SetTOFe_sigma (Double_t TOFe_sigma = 3*ns   );
 			void SetAP_peak    (Double_t AP_peak    = 0      );
 			void SetPdfAreaSPE (TF1 *SPEAreaPdf);
+			void SetSeed       (UInt_t Seed) {fRND.SetSeed(Seed);}
+			// TF1::Eval is not thread-safe: threads 1..NumThreads-1 evaluate own copies of TF1 shape.
+			// Copies are made again by SetShape (call it again after changing parameters of shape)
+			void SetNumThreads (Int_t NumThreads);
+			// Take shape area and SPE area CDF from Cache (compute and add them if absent) in CalculateParams.
+			// ModelKey must be hash of all parameters of shape and SPE area pdf
+			void SetCache      (PrecompCache *Cache, ULong64_t ModelKey) {fCache = Cache; fModelKey = ModelKey;}
 
 		// GETTERS
 			// Get SPE parameters
@@ -145,7 +165,12 @@ namespace RED
 			Double_t GetShapeArea()   const {return fShapeArea;}
 			Double_t GetAmpl()        const {return fAmpl_mean;}
 			Double_t GetAmpl_Sigma()  const {return fAmpl_sigma;}
+			Double_t GetDelayMin()    const; // Range of ToF of PC and 1dyn SPE (8 sigma)
+			Double_t GetDelayMax()    const;
+			PrecompCache* GetCache()  const {return fCache;}
+			ULong64_t GetModelKey()   const {return fModelKey;}
 			Double_t Eval(Double_t t) const;
+			Double_t Eval(Double_t t, Int_t Thread) const;
 			// Get independent PMT parameters
 			Double_t GetQE()          const {return fQE;}
 			Double_t GetDPE_PC()      const {return fDPE_PC;}
@@ -164,6 +189,7 @@ namespace RED
 			int  Begin     (PulseArray &electrons);
 			int  End       (PulseArray &electrons);
 			Char_t OnePhoton (Double_t time, PulseArray &electrons, bool fDebug=true);
+			void ManyPhotons (const Double_t *times, Int_t n, PulseArray &electrons, Double_t Offset = 0); // Random numbers are drawn in batches
 			void GenDCR    (Double_t begintime, Double_t endtime, PulseArray& electrons);
 			void Clear     (Option_t *option="");
 
@@ -202,14 +228,29 @@ namespace RED
 			Double_t fArea_1d_sigma;   // = Area_sigma / Gain_PC_1d
 			Double_t fTOFe_1d_mean;    // Time of Flight e- from 1dyn to anode
 			Double_t fTOFe_1d_sigma;   // 0.5*TOF_sigma    
-			TRandom3 fRND;             // Object for random calculations
+			BulkRNG fRND;              // Object for random calculations
+			std::vector<Double_t> fBufU;    // Batches of random numbers for ManyPhotons and GenDCR
+			std::vector<Double_t> fBufA;
+			std::vector<Double_t> fBufG;
 			TF1 *fSPEAreaPdf;           // PDF for SPE area distribution
+			std::vector<Double_t> fAreaCDF; // Tabulated CDF of fSPEAreaPdf (filled by CalculateParams)
+			Double_t fAreaMin;          // Left edge of tabulated CDF
+			Double_t fAreaStep;         // Bin width of tabulated CDF
+			PrecompCache *fCache;       // Cache of shape area and area CDF (0 - always compute)
+			std::vector<TF1*> fShapeCopies; // Copies of TF1 shape for rendering threads 1, 2, ...
+			ULong64_t fModelKey;
 
 			bool fDebug; //some extended info (just for debug)
 
 			// ACTIONS
+			void ClearShapeCopies ();
 			// Calculate integral of TSpline object in range (xmin,xmax) by rectangles method
 			Double_t SplineIntegral (TSpline* spline, Double_t xmin, Double_t xmax, Int_t nbins);
+			// Tabulate CDF of SPE area pdf and sample from it with own fRND
+			// (TF1::GetRandom uses gRandom and can't be called from several threads)
+			void FillAreaCDF (Int_t nbins);
+			Double_t GetRandomArea () {return AreaFromUniform (fRND.Rndm());}
+			Double_t AreaFromUniform (Double_t RND); // Inverse CDF of SPE area
 			// Some printing functions
 			void PrintUsrDefParams () const;
 			void PrintCalcParams   () const;
@@ -0,0 +1,282 @@
+#include <iostream>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "PhotonFile.h"
+
+using std::cout;
+using std::endl;
+
+static const char kPhotonMagic[8] = {'M','W','P','H','O','T','0','1'};
+static const UInt_t kPhotonPageSize = 4096;
+
+// Size rounded up to whole pages
+static ULong64_t PageRound (ULong64_t size) {
+	return (size + kPhotonPageSize - 1) / kPhotonPageSize * kPhotonPageSize;
+}
+
+// WRITER
+
+PhotonFileWriter::PhotonFileWriter () {
+	fFD = -1;
+	fChannelsFD = -1;
+}
+
+PhotonFileWriter::~PhotonFileWriter () {
+	Close();
+}
+
+Bool_t PhotonFileWriter::WriteAt (int fd, const void *data, size_t size, ULong64_t offset) {
+	const char *ptr = (const char*) data;
+	while (size) {
+		ssize_t written = pwrite (fd, ptr, size, offset);
+		if (written <= 0) {
+			cout << "ERROR. Photon file can't be written" << endl;
+			return false;
+		}
+		ptr    += written;
+		size   -= written;
+		offset += written;
+	}
+	return true;
+}
+
+Bool_t PhotonFileWriter::Open (const char *filename, Bool_t WithChannels) {
+	Close();
+	fFD = open (filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fFD < 0) {
+		cout << "ERROR. File " << filename << " can't be written" << endl;
+		return false;
+	}
+	if (WithChannels) {
+		fChannelsName = string (filename) + ".channels.tmp";
+		fChannelsFD = open (fChannelsName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fChannelsFD < 0) {
+			cout << "ERROR. File " << fChannelsName << " can't be written" << endl;
+			close (fFD);
+			fFD = -1;
+			return false;
+		}
+	}
+	memset (&fHeader, 0, sizeof(fHeader));
+	memcpy (fHeader.fMagic, kPhotonMagic, sizeof(kPhotonMagic));
+	fHeader.fPageSize    = kPhotonPageSize;
+	fHeader.fHasChannels = WithChannels;
+	fHeader.fTimesOffset = kPhotonPageSize;
+	fOffsets.assign (1, 0);
+	vector <char> page (kPhotonPageSize, 0);
+	memcpy (&page[0], &fHeader, sizeof(fHeader));
+	return WriteAt (fFD, &page[0], kPhotonPageSize, 0);
+}
+
+Bool_t PhotonFileWriter::AddEvent (const Double_t *Times, Int_t NumPhotons, const Short_t *Channels) {
+	if (fFD < 0) {
+		cout << "ERROR. Photon file was not created" << endl;
+		return false;
+	}
+	if (fChannelsFD >= 0 && NumPhotons && !Channels) {
+		cout << "ERROR. Channels of photons are required by photon file" << endl;
+		return false;
+	}
+	ULong64_t First = fHeader.fNumPhotons;
+	if (NumPhotons) {
+		if (!WriteAt (fFD, Times, NumPhotons * sizeof(Double_t), fHeader.fTimesOffset + First * sizeof(Double_t)))
+			return false;
+		if (fChannelsFD >= 0 && !WriteAt (fChannelsFD, Channels, NumPhotons * sizeof(Short_t), First * sizeof(Short_t)))
+			return false;
+	}
+	fHeader.fNumPhotons += NumPhotons;
+	fHeader.fNumEvents++;
+	fOffsets.push_back (fHeader.fNumPhotons);
+	return true;
+}
+
+Bool_t PhotonFileWriter::Close () {
+	if (fFD < 0)
+		return false;
+	Bool_t ok = true;
+	ULong64_t End = PageRound (fHeader.fTimesOffset + fHeader.fNumPhotons * sizeof(Double_t));
+
+	// Copy channels after times
+	if (fChannelsFD >= 0) {
+		fHeader.fChannelsOffset = End;
+		vector <char> Buffer (1 << 20);
+		ULong64_t Size = fHeader.fNumPhotons * sizeof(Short_t);
+		for (ULong64_t pos = 0; ok && pos < Size; ) {
+			ssize_t n = pread (fChannelsFD, &Buffer[0], Buffer.size(), pos);
+			if (n <= 0) {
+				cout << "ERROR. File " << fChannelsName << " can't be read" << endl;
+				ok = false;
+				break;
+			}
+			ok = WriteAt (fFD, &Buffer[0], n, End + pos);
+			pos += n;
+		}
+		End = PageRound (End + Size);
+		close (fChannelsFD);
+		unlink (fChannelsName.c_str());
+		fChannelsFD = -1;
+	}
+
+	// Offsets of events
+	fHeader.fOffsetsOffset = End;
+	ok = ok && WriteAt (fFD, &fOffsets[0], fOffsets.size() * sizeof(ULong64_t), End);
+	ok = ok && WriteAt (fFD, &fHeader, sizeof(fHeader), 0);
+	close (fFD);
+	fFD = -1;
+	fOffsets.clear();
+	return ok;
+}
+
+// READER
+
+PhotonFileReader::PhotonFileReader () {
+	fFD        = -1;
+	fMap       = 0;
+	fMapSize   = 0;
+	fHeader    = 0;
+	fTimes     = 0;
+	fChannels  = 0;
+	fOffsets   = 0;
+	fReadAhead = 64 << 20;
+	fReadUpTo     = 0;
+	fReleasedUpTo = 0;
+}
+
+PhotonFileReader::~PhotonFileReader () {
+	Close();
+}
+
+Bool_t PhotonFileReader::Open (const char *filename) {
+	Close();
+	fFD = open (filename, O_RDONLY);
+	if (fFD < 0) {
+		cout << "ERROR. File " << filename << " can't be read" << endl;
+		return false;
+	}
+	struct stat st;
+	PhotonFileHeader header;
+	if (fstat (fFD, &st) || pread (fFD, &header, sizeof(header), 0) != sizeof(header) ||
+	    memcmp (header.fMagic, kPhotonMagic, sizeof(kPhotonMagic)) || header.fPageSize != kPhotonPageSize) {
+		cout << "ERROR. File " << filename << " is not a photon file" << endl;
+		Close();
+		return false;
+	}
+	if (!header.fOffsetsOffset || header.fNumEvents >= (ULong64_t) st.st_size / sizeof(ULong64_t) ||
+	    header.fOffsetsOffset + (header.fNumEvents + 1) * sizeof(ULong64_t) > (ULong64_t) st.st_size) {
+		cout << "ERROR. Photon file " << filename << " was not closed" << endl;
+		Close();
+		return false;
+	}
+	// Columns must be inside file (truncated file would give SIGBUS on reading)
+	ULong64_t Size = st.st_size;
+	if (header.fNumPhotons > Size / sizeof(Double_t) || header.fTimesOffset > Size ||
+	    header.fTimesOffset + header.fNumPhotons * sizeof(Double_t) > Size ||
+	    (header.fHasChannels && (header.fChannelsOffset > Size ||
+	                             header.fChannelsOffset + header.fNumPhotons * sizeof(Short_t) > Size))) {
+		cout << "ERROR. Photon file " << filename << " is truncated" << endl;
+		Close();
+		return false;
+	}
+	fMapSize = st.st_size;
+	fMap = (char*) mmap (0, fMapSize, PROT_READ, MAP_SHARED, fFD, 0);
+	if (fMap == MAP_FAILED) {
+		cout << "ERROR. Photon file can't be mapped" << endl;
+		fMap = 0;
+		Close();
+		return false;
+	}
+	madvise (fMap, fMapSize, MADV_SEQUENTIAL);
+	fHeader   = (const PhotonFileHeader*) fMap;
+	fTimes    = (const Double_t*) (fMap + fHeader->fTimesOffset);
+	fChannels = fHeader->fHasChannels ? (const Short_t*) (fMap + fHeader->fChannelsOffset) : 0;
+	fOffsets  = (const ULong64_t*) (fMap + fHeader->fOffsetsOffset);
+	Bool_t Valid = fOffsets[0] == 0 && fOffsets[fHeader->fNumEvents] == fHeader->fNumPhotons;
+	for (ULong64_t ev = 0; Valid && ev < fHeader->fNumEvents; ev++)
+		Valid = fOffsets[ev] <= fOffsets[ev + 1];
+	if (!Valid) {
+		cout << "ERROR. Photon file " << filename << " has corrupt offsets of events" << endl;
+		Close();
+		return false;
+	}
+	fReadUpTo     = 0;
+	fReleasedUpTo = 0;
+	return true;
+}
+
+void PhotonFileReader::Close () {
+	if (fMap)
+		munmap (fMap, fMapSize);
+	fMap      = 0;
+	fMapSize  = 0;
+	fHeader   = 0;
+	fTimes    = 0;
+	fChannels = 0;
+	fOffsets  = 0;
+	if (fFD >= 0)
+		close (fFD);
+	fFD = -1;
+}
+
+// Pages of photons [First, Last) in columns. Pages for MADV_DONTNEED are taken
+// only if they are completely inside the range (neighbour photons stay mapped)
+void PhotonFileReader::Advise (ULong64_t First, ULong64_t Last, int Advice) {
+	if (First >= Last)
+		return;
+	const ULong64_t Columns[2][2] = {
+		{fHeader->fTimesOffset, sizeof(Double_t)},
+		{fHeader->fChannelsOffset, sizeof(Short_t)}
+	};
+	for (Int_t col = 0; col < (fChannels ? 2 : 1); col++) {
+		ULong64_t Begin = Columns[col][0] + First * Columns[col][1];
+		ULong64_t End   = Columns[col][0] + Last  * Columns[col][1];
+		if (Advice == MADV_DONTNEED) {
+			Begin = PageRound (Begin);
+			End   = End / kPhotonPageSize * kPhotonPageSize;
+		}
+		else {
+			Begin = Begin / kPhotonPageSize * kPhotonPageSize;
+			End   = PageRound (End);
+		}
+		if (End > fMapSize)
+			End = fMapSize;
+		if (Begin < End)
+			madvise (fMap + Begin, End - Begin, Advice);
+	}
+}
+
+Bool_t PhotonFileReader::GetEvent (Long64_t ev, PhotonSpan &Span) {
+	if (!fMap || ev < 0 || ev >= GetNumEvents()) {
+		cout << "ERROR. Event " << ev << " is absent in photon file" << endl;
+		return false;
+	}
+	ULong64_t First = fOffsets[ev];
+	ULong64_t Last  = fOffsets[ev+1];
+	Span.fEventID    = ev;
+	Span.fNumPhotons = Last - First;
+	Span.fTimes      = fTimes + First;
+	Span.fChannels   = fChannels ? fChannels + First : 0;
+
+	// Jump out of the current sequential range
+	if (First < fReleasedUpTo || First > fReadUpTo)
+		fReleasedUpTo = fReadUpTo = First;
+	// Read ahead when less than half of read-ahead range is left
+	ULong64_t Ahead = fReadAhead / sizeof(Double_t);
+	if (Last + Ahead / 2 > fReadUpTo) {
+		ULong64_t UpTo = Last + Ahead;
+		if (UpTo > fHeader->fNumPhotons)
+			UpTo = fHeader->fNumPhotons;
+		Advise (fReadUpTo, UpTo, MADV_WILLNEED);
+		fReadUpTo = UpTo;
+	}
+	// Release pages far behind
+	if (First > fReleasedUpTo + Ahead) {
+		Advise (fReleasedUpTo, First, MADV_DONTNEED);
+		fReleasedUpTo = First;
+	}
+	return true;
+}
@@ -0,0 +1,109 @@
+#ifndef PhotonFile_H
+#define PhotonFile_H
+
+#include <vector>
+#include <string>
+
+#include <Rtypes.h>
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Columnar file of photon arrival times (e.g. from optical simulation).   //
+//                                                                         //
+// File consists of header and three columns, each starts at page:         //
+//   PhotonFileHeader                                                      //
+//   times    - Double_t for each photon, events one after another         //
+//   channels - Short_t channel of each photon (optional)                  //
+//   offsets  - ULong64_t index of first photon of each event (plus total) //
+// Writer streams times to file while events are added, channels go to     //
+// temporary file; columns of channels and offsets are put after times by  //
+// Close(), so file of any size is written with constant memory.           //
+//                                                                         //
+// PhotonFileReader maps the file into memory and gives spans of events    //
+// pointing directly into the mapping (no copy), which may be passed to    //
+// MakeWave::SetPhotonTimes. Reading is sequential: reader asks kernel to  //
+// read ahead next ReadAhead bytes of columns and releases pages behind    //
+// current event, so memory used doesn't depend on size of file.           //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+using std::string;
+
+struct PhotonFileHeader {
+	char      fMagic[8];        // "MWPHOT01"
+	UInt_t    fPageSize;        // Alignment of columns
+	UInt_t    fHasChannels;     // Channels column is present
+	ULong64_t fNumEvents;
+	ULong64_t fNumPhotons;
+	ULong64_t fTimesOffset;     // Offsets of columns in file
+	ULong64_t fChannelsOffset;  // 0 if there are no channels
+	ULong64_t fOffsetsOffset;   // 0 while file is written
+};
+
+// Photons of one event in mapped file. Valid until Close() of reader
+struct PhotonSpan {
+	Long64_t fEventID;
+	Int_t fNumPhotons;
+	const Double_t *fTimes;
+	const Short_t *fChannels;  // 0 if file has no channels
+};
+
+class PhotonFileWriter
+{
+	public:
+
+		PhotonFileWriter ();
+		~PhotonFileWriter ();
+
+		Bool_t Open (const char *filename, Bool_t WithChannels = false);
+		Bool_t AddEvent (const Double_t *Times, Int_t NumPhotons, const Short_t *Channels = 0); // Append event
+		Bool_t AddEvent (const vector <double> &Times) {return AddEvent (Times.size() ? &Times[0] : 0, Times.size());}
+		Bool_t Close (); // Write channels and offsets columns and close file
+		Bool_t IsOpen () {return fFD >= 0;}
+
+	private:
+
+		Bool_t WriteAt (int fd, const void *data, size_t size, ULong64_t offset);
+
+		int fFD;                    // File descriptor
+		int fChannelsFD;            // Temporary file for channels
+		string fChannelsName;
+		PhotonFileHeader fHeader;
+		vector <ULong64_t> fOffsets; // First photon of each event
+};
+
+class PhotonFileReader
+{
+	public:
+
+		PhotonFileReader ();
+		~PhotonFileReader ();
+
+		Bool_t Open (const char *filename);
+		void Close ();
+		void SetReadAhead (size_t Bytes) {fReadAhead = Bytes;} // Size of read-ahead (default 64 MB)
+
+		Long64_t GetNumEvents ()   {return fHeader ? fHeader->fNumEvents : 0;}
+		Long64_t GetNumPhotons ()  {return fHeader ? fHeader->fNumPhotons : 0;}
+		Bool_t   HasChannels ()    {return fChannels != 0;}
+		Int_t    GetNumPhotons (Long64_t ev) {return fOffsets[ev+1] - fOffsets[ev];}
+		Bool_t GetEvent (Long64_t ev, PhotonSpan &Span); // Zero-copy span of event ev
+
+	private:
+
+		void Advise (ULong64_t First, ULong64_t Last, int Advice); // Advice for photons [First, Last) in all columns
+
+		int fFD;
+		char *fMap;               // Mapped file
+		size_t fMapSize;
+		const PhotonFileHeader *fHeader;
+		const Double_t  *fTimes;
+		const Short_t   *fChannels;
+		const ULong64_t *fOffsets;
+		size_t fReadAhead;        // Bytes of times column to read ahead
+		ULong64_t fReadUpTo;      // Photons up to this one were requested to read
+		ULong64_t fReleasedUpTo;  // Photons before this one were released
+};
+
+#endif // PhotonFile_H
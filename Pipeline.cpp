@@ -0,0 +1,210 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+
+#include <TROOT.h>
+
+#include "Pipeline.h"
+#include "ElecChain.h"
+
+using std::cout;
+using std::endl;
+
+typedef std::chrono::steady_clock Clock;
+
+// Seconds since moment Start
+static Double_t Since (Clock::time_point Start) {
+	return std::chrono::duration <double> (Clock::now() - Start).count();
+}
+
+PipeStage::PipeStage (const char *Name) {
+	fName         = Name;
+	fNumProcessed = 0;
+	fWorkTime     = 0;
+	fWaitInTime   = 0;
+	fWaitOutTime  = 0;
+	fSumOccupancy = 0;
+}
+
+Pipeline::Pipeline (Int_t PoolSize, Int_t QueueSize) {
+	fPool.resize (PoolSize);
+	fQueueSize = QueueSize;
+	fRunTime   = 0;
+	fQueues.push_back (new RingBuffer <PipeEvent*> (PoolSize));
+}
+
+Pipeline::~Pipeline () {
+	for (unsigned int i = 0; i < fQueues.size(); i++)
+		delete fQueues[i];
+	for (unsigned int st = 0; st < fStages.size(); st++)
+		delete fStages[st];
+}
+
+void Pipeline::AddStage (PipeStage *Stage) {
+	if (fStages.size())
+		fQueues.push_back (new RingBuffer <PipeEvent*> (fQueueSize));
+	fStages.push_back (Stage);
+}
+
+void Pipeline::Run (Int_t NumEvents) {
+	if (!fStages.size()) {
+		cout << "ERROR. Pipeline has no stages" << endl;
+		return;
+	}
+	ROOT::EnableThreadSafety();
+
+	// All events of pool are free
+	PipeEvent *Event = 0;
+	while (fQueues[0]->TryPop (Event)) { ; }
+	for (unsigned int i = 0; i < fPool.size(); i++)
+		fQueues[0]->TryPush (&fPool[i]);
+
+	for (unsigned int st = 0; st < fStages.size(); st++)
+		fStages[st]->BeginOfRun();
+	Clock::time_point Start = Clock::now();
+	vector <std::thread> Threads;
+	for (unsigned int st = 0; st < fStages.size(); st++)
+		Threads.push_back (std::thread (&Pipeline::RunStage, this, st, NumEvents));
+	for (unsigned int st = 0; st < fStages.size(); st++)
+		Threads[st].join();
+	fRunTime = Since (Start);
+	for (unsigned int st = 0; st < fStages.size(); st++)
+		fStages[st]->EndOfRun();
+}
+
+// Stage st takes events from fQueues[st] and passes them to next queue.
+// The last stage returns events to the pool. The first stage stops after
+// NumEvents events and sends 0 as end-of-run mark to the next stages.
+void Pipeline::RunStage (Int_t st, Int_t NumEvents) {
+	PipeStage *Stage = fStages[st];
+	RingBuffer <PipeEvent*> *In  = fQueues[st];
+	RingBuffer <PipeEvent*> *Out = fQueues[(st + 1) % fQueues.size()];
+	bool IsLast = (st == (Int_t) fStages.size() - 1);
+	PipeEvent *Event = 0;
+	Clock::time_point Start;
+
+	for (Int_t id = 0; st != 0 || id < NumEvents; id++) {
+		// Get input event
+		Start = Clock::now();
+		Stage->fSumOccupancy += In->GetSize();
+		while (!In->TryPop (Event))
+			std::this_thread::yield();
+		Stage->fWaitInTime += Since (Start);
+		if (!Event)
+			break;
+
+		// Process it
+		Start = Clock::now();
+		if (st == 0)
+			Event->fID = id;
+		Stage->Process (Event);
+		Stage->fWorkTime += Since (Start);
+		Stage->fNumProcessed++;
+
+		// Pass it further
+		Start = Clock::now();
+		while (!Out->TryPush (Event))
+			std::this_thread::yield();
+		Stage->fWaitOutTime += Since (Start);
+	}
+
+	// Send end-of-run mark
+	if (!IsLast) {
+		while (!Out->TryPush (0))
+			std::this_thread::yield();
+	}
+}
+
+void Pipeline::PrintStats () {
+	// The bottleneck is the stage which works longest
+	Int_t Bottleneck = 0;
+	for (unsigned int st = 0; st < fStages.size(); st++) {
+		if (fStages[st]->GetWorkTime() > fStages[Bottleneck]->GetWorkTime())
+			Bottleneck = st;
+	}
+	cout << "Pipeline run time " << fRunTime << " s" << endl;
+	cout << std::setiosflags(std::ios::fixed) << std::setprecision(3);
+	cout << "  Stage          Events   Work, s    Wait in, s  Wait out, s  Queue fill" << endl;
+	for (unsigned int st = 0; st < fStages.size(); st++) {
+		PipeStage *Stage = fStages[st];
+		cout << "  " << std::setw(12) << std::left << Stage->GetName() << std::right;
+		cout << std::setw(9)  << Stage->GetNumProcessed();
+		cout << std::setw(11) << Stage->GetWorkTime();
+		cout << std::setw(13) << Stage->GetWaitInTime();
+		cout << std::setw(13) << Stage->GetWaitOutTime();
+		cout << std::setw(8)  << Stage->GetOccupancy() << " / " << fQueues[st]->GetCapacity();
+		if ((Int_t) st == Bottleneck)
+			cout << "  <- bottleneck";
+		cout << endl;
+	}
+	cout << std::resetiosflags(std::ios::fixed) << std::setprecision(6);
+}
+
+// STANDARD STAGES
+
+SimStage::SimStage (SimPhotons *Photons, Option_t *Type, Int_t FirstPhotons, Int_t StepPhotons) : PipeStage ("Simulation") {
+	fPhotons      = Photons;
+	fType         = Type;
+	fFirstPhotons = FirstPhotons;
+	fStepPhotons  = StepPhotons;
+}
+
+void SimStage::Process (PipeEvent *Event) {
+	Event->fPhotonTimes = fPhotons->SimulatePhotons (fFirstPhotons + Event->fID * fStepPhotons, fType.c_str());
+}
+
+PMTStage::PMTStage (MakeWave *MakeWaveObj) : PipeStage ("PMT") {
+	fMakeWave = MakeWaveObj;
+}
+
+void PMTStage::Process (PipeEvent *Event) {
+	fMakeWave->GenElectrons (Event->fPhotonTimes, Event->fPhotoElectrons, Event->fDarkElectrons);
+}
+
+RenderStage::RenderStage (MakeWave *MakeWaveObj) : PipeStage ("Rendering") {
+	fMakeWave = MakeWaveObj;
+}
+
+static const Int_t kRenderThread = 1; // Thread 0 is used by PMTStage (generation of SPE)
+
+void RenderStage::BeginOfRun () {
+	fMakeWave->GetPMT()->SetNumThreads (kRenderThread + 1);
+	if (fMakeWave->GetElecChain())
+		fMakeWave->GetElecChain()->SetNumThreads (kRenderThread + 1);
+}
+
+void RenderStage::Process (PipeEvent *Event) {
+	fMakeWave->RenderWave (Event->fPhotoElectrons, Event->fDarkElectrons, Event->fOutWave, 0, kRenderThread);
+}
+
+OutStage::OutStage (MakeWave *MakeWaveObj, Hist2D *FracHist, Double_t FracTime) : PipeStage ("Output") {
+	fMakeWave = MakeWaveObj;
+	fFracHist = FracHist;
+	fOwnHist  = 0;
+	if (FracHist) {
+		fOwnHist = new Hist2D (*FracHist); // The same binning
+		fOwnHist->Reset();
+	}
+	fFracTime = FracTime;
+}
+
+OutStage::~OutStage () {
+	delete fOwnHist;
+}
+
+void OutStage::Process (PipeEvent *Event) {
+	fMakeWave->AddToFile (Event->fOutWave);
+	if (fOwnHist) {
+		Double_t Frac = fMakeWave->GetFrac (Event->fPhotoElectrons, fFracTime);
+		if (Frac)
+			fOwnHist->Fill (Event->fPhotoElectrons.size(), Frac);
+	}
+}
+
+void OutStage::EndOfRun () {
+	if (!fOwnHist)
+		return;
+	fFracHist->Merge (*fOwnHist);
+	fOwnHist->Reset();
+}
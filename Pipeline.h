@@ -0,0 +1,190 @@
+#ifndef Pipeline_H
+#define Pipeline_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <Rtypes.h>
+
+#include "MakeWave.h"
+#include "SimPhotons.h"
+#include "Hist2D.h"
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Pipelined execution of events simulation.                               //
+// Each stage (photons simulation, PMT, rendering, output) runs in its     //
+// own thread. Stages are connected by bounded single-producer /           //
+// single-consumer ring buffers carrying events from a fixed pool, so a    //
+// slow stage holds back the previous ones (backpressure).                 //
+// For each stage the time of work, of waiting for input and of waiting    //
+// for free place in output queue is measured. The bottleneck is the       //
+// stage with the largest work time, the other stages wait for it.         //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+// Event travelling through the pipeline
+struct PipeEvent {
+	Int_t fID;                             // Number of event in run
+	vector <double> fPhotonTimes;          // Photons arrival times
+	RED::PMT::PulseArray fPhotoElectrons;  // array of SPE caused by photons
+	RED::PMT::PulseArray fDarkElectrons;   // array of SPE caused by dark counts
+	vector <double> fOutWave;              // Output waveform
+};
+
+// Bounded lock-free queue for one producer thread and one consumer thread
+template <class T> class RingBuffer
+{
+	public:
+
+		RingBuffer (Int_t Capacity) : fBuffer (Capacity + 1), fHead (0), fTail (0) { ; }
+
+		// Return false if queue is full
+		bool TryPush (const T &Item) {
+			UInt_t tail = fTail.load (std::memory_order_relaxed);
+			UInt_t next = (tail + 1) % fBuffer.size();
+			if (next == fHead.load (std::memory_order_acquire))
+				return false;
+			fBuffer[tail] = Item;
+			fTail.store (next, std::memory_order_release);
+			return true;
+		}
+
+		// Return false if queue is empty
+		bool TryPop (T &Item) {
+			UInt_t head = fHead.load (std::memory_order_relaxed);
+			if (head == fTail.load (std::memory_order_acquire))
+				return false;
+			Item = fBuffer[head];
+			fHead.store ((head + 1) % fBuffer.size(), std::memory_order_release);
+			return true;
+		}
+
+		Int_t GetSize () const {
+			Int_t size = (Int_t) fTail.load (std::memory_order_acquire) - (Int_t) fHead.load (std::memory_order_acquire);
+			return size < 0 ? size + fBuffer.size() : size;
+		}
+		Int_t GetCapacity () const {return fBuffer.size() - 1;}
+
+	private:
+
+		vector <T> fBuffer;
+		alignas(64) std::atomic <UInt_t> fHead; // Next item to pop (changed by consumer only)
+		alignas(64) std::atomic <UInt_t> fTail; // Next free place (changed by producer only)
+};
+
+// Base class for pipeline stage
+class PipeStage
+{
+		friend class Pipeline;
+
+	public:
+
+		PipeStage (const char *Name);
+		virtual ~PipeStage () { ; }
+
+		virtual void BeginOfRun () { ; }             // Called by thread of Run() before stage threads are started
+		virtual void Process (PipeEvent *Event) = 0; // Work of stage on one event
+		virtual void EndOfRun () { ; }               // Called by thread of Run() after all stages are finished
+
+	// GETTERS
+		const char* GetName ()      {return fName.c_str();}
+		Long64_t GetNumProcessed () {return fNumProcessed;}
+		Double_t GetWorkTime ()     {return fWorkTime;}    // Time of Process() calls, s
+		Double_t GetWaitInTime ()   {return fWaitInTime;}  // Time of waiting for input event, s
+		Double_t GetWaitOutTime ()  {return fWaitOutTime;} // Time of waiting for place in output queue (backpressure), s
+		Double_t GetOccupancy ()    {return fNumProcessed ? fSumOccupancy / fNumProcessed : 0;} // Mean fill of input queue
+
+	private:
+
+		std::string fName;
+		Long64_t fNumProcessed;
+		Double_t fWorkTime;
+		Double_t fWaitInTime;
+		Double_t fWaitOutTime;
+		Double_t fSumOccupancy;
+};
+
+class Pipeline
+{
+	public:
+
+		Pipeline (Int_t PoolSize = 16, Int_t QueueSize = 4);
+		~Pipeline (); // Deletes stages
+
+		void AddStage (PipeStage *Stage); // Stages are executed in order of adding (pipeline owns them)
+		void Run (Int_t NumEvents);       // Pass events 0..NumEvents-1 through all stages
+		void PrintStats ();               // Print time balance of stages
+
+	private:
+
+		// Prevent simple copy (pipeline owns stages and queues)
+		Pipeline (const Pipeline &r);
+		Pipeline & operator= (const Pipeline &r);
+
+		void RunStage (Int_t st, Int_t NumEvents); // Body of stage thread
+
+		vector <PipeStage*> fStages;
+		vector <RingBuffer <PipeEvent*>*> fQueues; // fQueues[0] - free events of pool, fQueues[i] - from stage i-1 to stage i
+		vector <PipeEvent> fPool;                  // Events in flight
+		Int_t fQueueSize;
+		Double_t fRunTime;                         // Wall time of last run, s
+};
+
+// STANDARD STAGES
+
+// Simulate photons for event with (FirstPhotons + ID*StepPhotons) photons
+class SimStage : public PipeStage
+{
+	public:
+		SimStage (SimPhotons *Photons, Option_t *Type, Int_t FirstPhotons, Int_t StepPhotons = 1);
+		void Process (PipeEvent *Event);
+	private:
+		SimPhotons *fPhotons;
+		std::string fType;
+		Int_t fFirstPhotons;
+		Int_t fStepPhotons;
+};
+
+// Convert photons to SPE and generate dark counts
+class PMTStage : public PipeStage
+{
+	public:
+		PMTStage (MakeWave *MakeWaveObj);
+		void Process (PipeEvent *Event);
+	private:
+		MakeWave *fMakeWave;
+};
+
+// Create waveform from SPE. It runs concurrently with PMTStage of the same
+// MakeWave, so it evaluates its own copy of SPE shape (rendering thread 1)
+class RenderStage : public PipeStage
+{
+	public:
+		RenderStage (MakeWave *MakeWaveObj);
+		void BeginOfRun ();
+		void Process (PipeEvent *Event);
+	private:
+		MakeWave *fMakeWave;
+};
+
+// Write waveform to current REDFile of MakeWave and fill F90 histogram (if given).
+// Stage fills its own copy of histogram, which is added to FracHist at the end of run
+class OutStage : public PipeStage
+{
+	public:
+		OutStage (MakeWave *MakeWaveObj, Hist2D *FracHist = 0, Double_t FracTime = 90*ns);
+		~OutStage ();
+		void Process (PipeEvent *Event);
+		void EndOfRun ();
+	private:
+		MakeWave *fMakeWave;
+		Hist2D *fFracHist;  // Histogram of owner
+		Hist2D *fOwnHist;   // Filled by thread of stage
+		Double_t fFracTime;
+};
+
+#endif // Pipeline_H
@@ -0,0 +1,177 @@
+#include <iostream>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+#include "PrecompCache.h"
+
+using std::cout;
+using std::endl;
+
+static const char kCacheFileMagic[8] = {'M','W','C','A','C','H','E','1'};
+static const ULong64_t kCachePageSize = 4096;
+
+struct CacheFileHeader {
+	char      fMagic[8];        // "MWCACHE1"
+	ULong64_t fNumEntries;      // Directory follows header
+};
+
+static ULong64_t CachePageRound (ULong64_t size) {
+	return (size + kCachePageSize - 1) / kCachePageSize * kCachePageSize;
+}
+
+CacheKey& CacheKey::Add (const void *Data, size_t Size) {
+	const UChar_t *bytes = (const UChar_t*) Data;
+	for (size_t i = 0; i < Size; i++) {
+		fHash ^= bytes[i];
+		fHash *= 0x100000001B3ULL;
+	}
+	return *this;
+}
+
+PrecompCache::PrecompCache () {
+	fFD      = -1;
+	fMap     = 0;
+	fMapSize = 0;
+}
+
+PrecompCache::~PrecompCache () {
+	Close();
+}
+
+Bool_t PrecompCache::Open (const char *filename) {
+	Close();
+	fFileName = filename;
+	if (access (filename, F_OK))
+		return true; // Will be created by first Add()
+	return Map();
+}
+
+void PrecompCache::Close () {
+	Unmap();
+	fFileName.clear();
+}
+
+void PrecompCache::Unmap () {
+	if (fMap)
+		munmap (fMap, fMapSize);
+	if (fFD >= 0)
+		close (fFD);
+	fMap     = 0;
+	fMapSize = 0;
+	fFD      = -1;
+	fEntries.clear();
+}
+
+Bool_t PrecompCache::Map () {
+	fFD = open (fFileName.c_str(), O_RDONLY);
+	struct stat st;
+	if (fFD < 0 || fstat (fFD, &st) || st.st_size < (off_t) sizeof(CacheFileHeader)) {
+		cout << "ERROR. Cache file " << fFileName << " can't be read" << endl;
+		Unmap();
+		return false;
+	}
+	fMapSize = st.st_size;
+	fMap = (char*) mmap (0, fMapSize, PROT_READ, MAP_SHARED, fFD, 0);
+	if (fMap == MAP_FAILED) {
+		cout << "ERROR. Cache file " << fFileName << " can't be mapped" << endl;
+		fMap = 0;
+		Unmap();
+		return false;
+	}
+	const CacheFileHeader *Header = (const CacheFileHeader*) fMap;
+	const Entry *Dir = (const Entry*) (fMap + sizeof(CacheFileHeader));
+	if (memcmp (Header->fMagic, kCacheFileMagic, sizeof(kCacheFileMagic)) ||
+	    sizeof(CacheFileHeader) + Header->fNumEntries * sizeof(Entry) > fMapSize) {
+		cout << "ERROR. File " << fFileName << " is not a cache file" << endl;
+		Unmap();
+		return false;
+	}
+	for (ULong64_t i = 0; i < Header->fNumEntries; i++) {
+		if (Dir[i].fOffset + Dir[i].fSize <= fMapSize)
+			fEntries.push_back (Dir[i]);
+	}
+	return true;
+}
+
+const void* PrecompCache::Find (ULong64_t Key, ULong64_t &Size) {
+	for (unsigned int i = 0; i < fEntries.size(); i++) {
+		if (fEntries[i].fKey == Key) {
+			Size = fEntries[i].fSize;
+			return fMap + fEntries[i].fOffset;
+		}
+	}
+	Size = 0;
+	return 0;
+}
+
+// Other processes may add tables at the same time, so the whole
+// read-merge-rename is done under lock of separate file (cache file
+// itself is replaced by rename)
+Bool_t PrecompCache::Add (ULong64_t Key, const void *Data, ULong64_t Size) {
+	if (!IsOpen())
+		return false;
+	string LockName = fFileName + ".lock";
+	int LockFD = open (LockName.c_str(), O_RDWR | O_CREAT, 0644);
+	if (LockFD < 0 || flock (LockFD, LOCK_EX)) {
+		cout << "ERROR. Cache lock " << LockName << " can't be taken" << endl;
+		if (LockFD >= 0)
+			close (LockFD);
+		return false;
+	}
+	Bool_t ok = Write (Key, Data, Size);
+	close (LockFD); // Releases lock
+	return ok;
+}
+
+// Tables of current file and the new one are written to temporary file,
+// which replaces cache file; then new file is mapped
+Bool_t PrecompCache::Write (ULong64_t Key, const void *Data, ULong64_t Size) {
+	// Take tables added by other processes since file was mapped
+	Unmap();
+	if (!access (fFileName.c_str(), F_OK))
+		Map(); // Unreadable file is replaced
+	ULong64_t OldSize;
+	if (Find (Key, OldSize))
+		return true; // Added by other process
+	vector <Entry> Entries (fEntries);
+	Entry New = {Key, 0, Size};
+	Entries.push_back (New);
+	ULong64_t Offset = CachePageRound (sizeof(CacheFileHeader) + Entries.size() * sizeof(Entry));
+	for (unsigned int i = 0; i < Entries.size(); i++) {
+		Entries[i].fOffset = Offset;
+		Offset = CachePageRound (Offset + Entries[i].fSize);
+	}
+
+	char TmpName[32];
+	snprintf (TmpName, sizeof(TmpName), ".tmp%d", (int) getpid());
+	string TmpFile = fFileName + TmpName;
+	FILE *file = fopen (TmpFile.c_str(), "wb");
+	if (!file) {
+		cout << "ERROR. Cache file " << TmpFile << " can't be written" << endl;
+		return false;
+	}
+	CacheFileHeader Header;
+	memcpy (Header.fMagic, kCacheFileMagic, sizeof(kCacheFileMagic));
+	Header.fNumEntries = Entries.size();
+	Bool_t ok = fwrite (&Header, sizeof(Header), 1, file) == 1 &&
+	            fwrite (&Entries[0], sizeof(Entry), Entries.size(), file) == Entries.size();
+	for (unsigned int i = 0; ok && i < Entries.size(); i++) {
+		const void *Table = i < fEntries.size() ? fMap + fEntries[i].fOffset : Data;
+		ok = !fseek (file, Entries[i].fOffset, SEEK_SET) &&
+		     (!Entries[i].fSize || fwrite (Table, Entries[i].fSize, 1, file) == 1);
+	}
+	ok = !fclose (file) && ok && !rename (TmpFile.c_str(), fFileName.c_str());
+	if (!ok) {
+		cout << "ERROR. Cache file " << fFileName << " can't be written" << endl;
+		unlink (TmpFile.c_str());
+		return false;
+	}
+
+	Unmap();
+	return Map();
+}
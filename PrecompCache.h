@@ -0,0 +1,98 @@
+#ifndef PrecompCache_H
+#define PrecompCache_H
+
+#include <vector>
+#include <string>
+#include <cstring>
+
+#include <Rtypes.h>
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Persistent cache of precomputed tables (SPE shape area, SPE area CDF,   //
+// tabulated SPE shapes, noise banks...), so that next start with the same //
+// model takes them from file instead of integrating and tabulating again. //
+//                                                                         //
+// Each table is identified by 64-bit key: hash of all model parameters    //
+// the table depends on plus name of the table (CacheKey). File consists   //
+// of header, directory of tables (key, offset, size) and data of tables,  //
+// each starts at page. File is mapped into memory by Open(), Find()       //
+// returns pointer into the mapping. Tables missing in file are added by   //
+// Add(), which rewrites file at once (new file is renamed over old one,   //
+// so parallel workers starting with the same cache never see a partly     //
+// written file). Add() holds flock on name.lock while it rereads file,    //
+// merges its tables with the new one and renames, so tables added by      //
+// other processes at the same time are not lost.                          //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+using std::string;
+
+// FNV-1a hash of model parameters
+class CacheKey
+{
+	public:
+
+		CacheKey (ULong64_t Seed = 0) : fHash (0xCBF29CE484222325ULL) {Add (&Seed, sizeof(Seed));}
+
+		CacheKey& Add (const void *Data, size_t Size);
+		CacheKey& Add (Double_t Value)         {return Add (&Value, sizeof(Value));}
+		CacheKey& Add (const char *Text)       {return Add (Text, std::strlen (Text));}
+		CacheKey& Add (const vector <double> &Values) {return Values.size() ? Add (&Values[0], Values.size() * sizeof(double)) : *this;}
+		ULong64_t Get () const {return fHash;}
+
+	private:
+
+		ULong64_t fHash;
+};
+
+class PrecompCache
+{
+	public:
+
+		PrecompCache ();
+		~PrecompCache ();
+
+		Bool_t Open (const char *filename); // Map existing cache (absent file is empty cache)
+		void Close ();
+		Bool_t IsOpen () {return fFileName.size() != 0;}
+
+		// Table with Key (0 if absent), Size - its size in bytes
+		const void* Find (ULong64_t Key, ULong64_t &Size);
+		// Copy table of Num values of type T to Values, return false if it is absent or has other size
+		template <class T> Bool_t Get (ULong64_t Key, vector <T> &Values, ULong64_t Num = 0);
+		Bool_t Add (ULong64_t Key, const void *Data, ULong64_t Size); // Add table and rewrite file
+		template <class T> Bool_t Add (ULong64_t Key, const vector <T> &Values) {
+			return Add (Key, Values.size() ? &Values[0] : 0, Values.size() * sizeof(T));
+		}
+
+	private:
+
+		struct Entry {
+			ULong64_t fKey;
+			ULong64_t fOffset;   // In file
+			ULong64_t fSize;     // Bytes
+		};
+
+		Bool_t Map ();   // Map file fFileName
+		void Unmap ();   // Release mapping (file name is kept)
+		Bool_t Write (ULong64_t Key, const void *Data, ULong64_t Size); // Rewrite file (under lock)
+
+		string fFileName;
+		int fFD;
+		char *fMap;
+		size_t fMapSize;
+		vector <Entry> fEntries;
+};
+
+template <class T> Bool_t PrecompCache::Get (ULong64_t Key, vector <T> &Values, ULong64_t Num) {
+	ULong64_t Size;
+	const T *Data = (const T*) Find (Key, Size);
+	if (!Data || Size % sizeof(T) || (Num && Size != Num * sizeof(T)))
+		return false;
+	Values.assign (Data, Data + Size / sizeof(T));
+	return true;
+}
+
+#endif // PrecompCache_H
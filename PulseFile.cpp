@@ -0,0 +1,216 @@
+#include <iostream>
+
+#include <TF1.h>
+#include <TSpline.h>
+#include <TNamed.h>
+
+#include "PulseFile.h"
+
+using std::cout;
+using std::endl;
+
+// WRITER
+
+PulseWriter::PulseWriter () {
+	fFile = 0;
+	fTree = 0;
+}
+
+PulseWriter::~PulseWriter () {
+	Close();
+}
+
+Bool_t PulseWriter::Open (const char *filename, MakeWave *MakeWaveObj, const char *ConfigText) {
+	Close();
+	fFile = new TFile (filename, "RECREATE");
+	if (fFile->IsZombie()) {
+		cout << "ERROR. File " << filename << " can't be written" << endl;
+		delete fFile;
+		fFile = 0;
+		return false;
+	}
+	fDelay = MakeWaveObj->GetDelay();
+
+	// Configuration of the run. Tree (not TParameter) is used, so files
+	// of shards can be merged by TFileMerger without summing of parameters
+	Double_t Period     = MakeWaveObj->GetPeriod();
+	Double_t Gain       = MakeWaveObj->GetGain();
+	Int_t    NumSamples = MakeWaveObj->GetNumSamples();
+	TTree *Config = new TTree ("Config", "OutWave parameters");
+	Config->Branch ("Period",     &Period);
+	Config->Branch ("Gain",       &Gain);
+	Config->Branch ("NumSamples", &NumSamples);
+	Config->Branch ("Delay",      &fDelay);
+	Config->Fill();
+	Config->Write();
+	RED::PMT *pmt = MakeWaveObj->GetPMT();
+	switch (pmt ? pmt->fMode : RED::PMT::kModeNone) {
+		case RED::PMT::kModeNone :
+			break;
+		case RED::PMT::kModeF1 :
+			pmt->fShape.func->Write ("SPEShape");
+			break;
+		case RED::PMT::kModeSpline :
+			pmt->fShape.spline->Write ("SPEShape");
+			break;
+	}
+	if (ConfigText)
+		TNamed ("RunConfig", ConfigText).Write();
+
+	fTree = new TTree ("Pulses", "SPE of events");
+	fTree->Branch ("NumPhotons", &fNumPhotons);
+	fTree->Branch ("Time",       &fTime);
+	fTree->Branch ("Ampl",       &fAmpl);
+	fTree->Branch ("Origin",     &fOrigin);
+	return true;
+}
+
+void PulseWriter::AddEvent (Int_t NumPhotons, const RED::PMT::PulseArray &PhotoElectrons,
+                            const RED::PMT::PulseArray &DarkElectrons) {
+	if (!fFile) {
+		cout << "ERROR. Pulse file was not created" << endl;
+		return;
+	}
+	fNumPhotons = NumPhotons;
+	fTime.clear();
+	fAmpl.clear();
+	fOrigin.clear();
+	for (unsigned int i = 0; i < PhotoElectrons.size(); i++) {
+		fTime.push_back (PhotoElectrons[i].fTime - fDelay);
+		fAmpl.push_back (PhotoElectrons[i].fAmpl);
+		fOrigin.push_back (kOriginPhoton);
+	}
+	for (unsigned int i = 0; i < DarkElectrons.size(); i++) {
+		fTime.push_back (DarkElectrons[i].fTime - fDelay);
+		fAmpl.push_back (DarkElectrons[i].fAmpl);
+		fOrigin.push_back (kOriginDark);
+	}
+	fTree->Fill();
+}
+
+void PulseWriter::Close () {
+	if (fFile) {
+		fFile->cd();
+		fTree->Write();
+		fFile->Close();
+		delete fFile;
+		fFile = 0;
+		fTree = 0;
+	}
+}
+
+// READER
+
+PulseReader::PulseReader () {
+	fFile   = 0;
+	fTree   = 0;
+	fTime   = 0;
+	fAmpl   = 0;
+	fOrigin = 0;
+}
+
+PulseReader::~PulseReader () {
+	Close();
+}
+
+Bool_t PulseReader::Open (const char *filename) {
+	Close();
+	fFile = TFile::Open (filename);
+	if (!fFile || fFile->IsZombie()) {
+		cout << "ERROR. File " << filename << " can't be read" << endl;
+		fFile = 0;
+		return false;
+	}
+	fFile->GetObject ("Pulses", fTree);
+	if (!fTree) {
+		cout << "ERROR. File " << filename << " has no pulses" << endl;
+		Close();
+		return false;
+	}
+	TTree *Config = 0;
+	fFile->GetObject ("Config", Config);
+	if (!Config) {
+		cout << "ERROR. File " << filename << " has no OutWave parameters" << endl;
+		Close();
+		return false;
+	}
+	Config->SetBranchAddress ("Period",     &fPeriod);
+	Config->SetBranchAddress ("Gain",       &fGain);
+	Config->SetBranchAddress ("NumSamples", &fNumSamples);
+	Config->SetBranchAddress ("Delay",      &fDelay);
+	Config->GetEntry (0);
+	fTree->SetBranchAddress ("NumPhotons", &fNumPhotons);
+	fTree->SetBranchAddress ("Time",       &fTime);
+	fTree->SetBranchAddress ("Ampl",       &fAmpl);
+	fTree->SetBranchAddress ("Origin",     &fOrigin);
+	return true;
+}
+
+void PulseReader::Close () {
+	if (fFile) {
+		fFile->Close();
+		delete fFile;
+		fFile = 0;
+		fTree = 0;
+	}
+}
+
+Long64_t PulseReader::GetNumEvents () {
+	return fTree ? fTree->GetEntries() : 0;
+}
+
+Bool_t PulseReader::ReadEvent (Long64_t ev, RED::PMT::PulseArray &PhotoElectrons, RED::PMT::PulseArray &DarkElectrons) {
+	if (!fTree || fTree->GetEntry (ev) <= 0) {
+		cout << "ERROR. Event " << ev << " can't be read" << endl;
+		return false;
+	}
+	PhotoElectrons.clear();
+	DarkElectrons.clear();
+	RED::PMT::Pulse OnePulse;
+	for (unsigned int i = 0; i < fTime->size(); i++) {
+		OnePulse.fTime = (*fTime)[i] + fDelay;
+		OnePulse.fAmpl = (*fAmpl)[i];
+		if ((*fOrigin)[i] == kOriginDark)
+			DarkElectrons.push_back (OnePulse);
+		else
+			PhotoElectrons.push_back (OnePulse);
+	}
+	return true;
+}
+
+RED::PMT_R11410* PulseReader::CreatePMT () {
+	TObject *Shape = fFile ? fFile->Get ("SPEShape") : 0;
+	if (!Shape) {
+		cout << "ERROR. Pulse file has no SPE shape" << endl;
+		return 0;
+	}
+	TF1     *Func   = dynamic_cast <TF1*> (Shape);
+	TSpline *Spline = dynamic_cast <TSpline*> (Shape);
+	if (!Func && !Spline) {
+		cout << "ERROR. SPE shape of pulse file is " << Shape->ClassName() << ", not TF1 or TSpline" << endl;
+		return 0;
+	}
+	RED::PMT_R11410 *pmt = new RED::PMT_R11410;
+	if (Func)
+		pmt->SetShape (Func);
+	else
+		pmt->SetShape (Spline);
+	return pmt;
+}
+
+MakeWave* PulseReader::CreateMakeWave () {
+	RED::PMT_R11410 *pmt = CreatePMT();
+	if (!pmt)
+		return 0;
+	MakeWave *MakeWaveObj = new MakeWave();
+	MakeWaveObj->SetPMT (pmt);
+	MakeWaveObj->SetOutWave (fPeriod, fGain, fNumSamples, fDelay);
+	return MakeWaveObj;
+}
+
+Bool_t PulseReader::RenderEvent (Long64_t ev, MakeWave *MakeWaveObj, vector <double> &OutWave) {
+	if (!ReadEvent (ev, fPhotoElectrons, fDarkElectrons))
+		return false;
+	MakeWaveObj->RenderWave (fPhotoElectrons, fDarkElectrons, OutWave);
+	return true;
+}
@@ -0,0 +1,111 @@
+#ifndef PulseFile_H
+#define PulseFile_H
+
+#include <vector>
+
+#include <Rtypes.h>
+#include <TFile.h>
+#include <TTree.h>
+
+#include "MakeWave.h"
+#include "PMT_R11410.hh"
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Truth-level output: instead of rendered waveform only SPE of each event //
+// (time, amplitude, origin) are written. It's enough to render waveform   //
+// again later, since it is fully determined by SPE, SPE shape and OutWave //
+// parameters.                                                             //
+//                                                                         //
+// File contains TTree "Pulses" (one entry per event, each column stored   //
+// in its own branch) and configuration of the run: TTree "Config" with    //
+// OutWave parameters (Period, Gain, NumSamples, Delay), SPE shape         //
+// ("SPEShape", TF1 or TSpline) and optional config text ("RunConfig").    //
+// Pulse times are stored relative to Delay (left edge of OutWave) as      //
+// Float_t: resolution is 6e-8 of time from the left edge (18 ps at end of //
+// 300 us window), much finer than sampling period for windows up to few   //
+// ms. Longer windows would need Double_t columns (new file format).       //
+//                                                                         //
+// PulseReader reads pulses back and renders waveform with any OutWave     //
+// parameters. Note that dark counts exist only in the original window.    //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+// Origin of pulse
+enum PulseOrigin {
+	kOriginPhoton = 0, // SPE caused by photon
+	kOriginDark   = 1  // SPE caused by dark count
+};
+
+class PulseWriter
+{
+	public:
+
+		PulseWriter ();
+		~PulseWriter ();
+
+		Bool_t Open (const char *filename, MakeWave *MakeWaveObj, const char *ConfigText = 0); // Create file, write configuration
+		void AddEvent (Int_t NumPhotons, const RED::PMT::PulseArray &PhotoElectrons,
+		               const RED::PMT::PulseArray &DarkElectrons); // Write pulses of one event
+		void Close ();
+		Bool_t IsOpen () {return fFile != 0;}
+
+	private:
+
+		TFile *fFile;
+		TTree *fTree;
+		Double_t fDelay;           // Left edge of OutWave
+		// Columns of current event
+		Int_t fNumPhotons;         // Number of photons in event
+		vector <Float_t> fTime;    // Time from left edge of OutWave
+		vector <Float_t> fAmpl;    // Amplitude of SPE shape
+		vector <UChar_t> fOrigin;  // PulseOrigin
+};
+
+class PulseReader
+{
+	public:
+
+		PulseReader ();
+		~PulseReader ();
+
+		Bool_t Open (const char *filename);
+		void Close ();
+
+	// GETTERS
+		Long64_t GetNumEvents ();
+		Int_t GetNumPhotons () {return fNumPhotons;} // Number of photons in last read event
+		// OutWave parameters of the run
+		Double_t GetPeriod ()     {return fPeriod;}
+		Double_t GetGain ()       {return fGain;}
+		Int_t    GetNumSamples () {return fNumSamples;}
+		Double_t GetDelay ()      {return fDelay;}
+
+	// ACTIONS
+		Bool_t ReadEvent (Long64_t ev, RED::PMT::PulseArray &PhotoElectrons, RED::PMT::PulseArray &DarkElectrons);
+		RED::PMT_R11410* CreatePMT (); // PMT with SPE shape of the run (enough for rendering only)
+		MakeWave* CreateMakeWave ();   // MakeWave with PMT and OutWave parameters of the run
+		// Render event with PMT and OutWave parameters of MakeWaveObj (they can differ from the run)
+		Bool_t RenderEvent (Long64_t ev, MakeWave *MakeWaveObj, vector <double> &OutWave);
+
+	private:
+
+		TFile *fFile;
+		TTree *fTree;
+		Double_t fPeriod;
+		Double_t fGain;
+		Int_t    fNumSamples;
+		Double_t fDelay;
+		// Columns of current event
+		Int_t fNumPhotons;
+		vector <Float_t> *fTime;
+		vector <Float_t> *fAmpl;
+		vector <UChar_t> *fOrigin;
+		// Pulses of current event
+		RED::PMT::PulseArray fPhotoElectrons;
+		RED::PMT::PulseArray fDarkElectrons;
+};
+
+#endif // PulseFile_H
@@ -0,0 +1,128 @@
+#include <iostream>
+
+#include <TFile.h>
+#include <TObjArray.h>
+#include <TBranch.h>
+
+#include "REDWriter.h"
+
+using std::cout;
+using std::endl;
+
+static const Long64_t kMinBasket     = 32000;     // ROOT default basket size
+static const Long64_t kMaxBasket     = 16 << 20;
+static const Long64_t kMinFlushBytes = 32 << 20;
+
+REDWriter::REDWriter (const char *filename, Int_t PoolSize) {
+	fDir         = 0;
+	fNumPooled   = 0;
+	fNumWritten  = 0;
+	fCompression = -1;
+	fFlushBytes  = 0;
+	fTuned       = false;
+	fRunInfo     = 0;
+	fFile = new RED::OutputFile (filename);
+	fFile->Open();
+	if (!fFile->IsOpen())
+		return;
+	fDir = gDirectory;
+	fRunInfo = new RED::RunInfo;
+	fPool.resize (PoolSize > 0 ? PoolSize : 1);
+	fWaveforms.resize (fPool.size());
+	for (unsigned int ev = 0; ev < fPool.size(); ev++) {
+		fPool[ev] = new RED::Event;
+		fPool[ev]->SetRunInfo (fRunInfo);
+		fPool[ev]->fNumChannels = 0;
+	}
+}
+
+REDWriter::~REDWriter () {
+	Close();
+	for (unsigned int ev = 0; ev < fPool.size(); ev++)
+		delete fPool[ev];
+	delete fFile;
+	delete fRunInfo;
+}
+
+Int_t REDWriter::AddWaveform (Int_t Channel, Double_t Period, Double_t Gain, Int_t NumSamples, Double_t Delay) {
+	for (unsigned int ev = 0; ev < fPool.size(); ev++) {
+		RED::Waveform *Waveform = fPool[ev]->GetNewWaveform();
+		Waveform->fChannel    = Channel;
+		Waveform->fPeriod     = Period;
+		Waveform->fGain       = Gain;
+		Waveform->fNumSamples = NumSamples;
+		Waveform->fDelay      = Delay;
+		Waveform->fData.reserve (NumSamples);
+		fWaveforms[ev].push_back (Waveform);
+		fPool[ev]->fNumChannels = fWaveforms[ev].size();
+	}
+	fLayout.push_back (NumSamples);
+	return fLayout.size() - 1;
+}
+
+Long64_t REDWriter::GetEventSize () {
+	Long64_t Size = 0;
+	for (unsigned int i = 0; i < fLayout.size(); i++)
+		Size += fLayout[i] * (Long64_t) sizeof(Double_t);
+	return Size;
+}
+
+void REDWriter::Commit () {
+	fNumPooled++;
+	if (fNumPooled == (Int_t) fPool.size())
+		Flush();
+}
+
+void REDWriter::Flush () {
+	if (!IsOpen()) {
+		cout << "ERROR. File can't be written" << endl;
+		fNumPooled = 0;
+		return;
+	}
+	for (Int_t ev = 0; ev < fNumPooled; ev++) {
+		fFile->WriteEvent (fPool[ev]);
+		if (!fTuned)
+			Tune(); // Tree is created by first event, the rest of pool goes to tuned baskets
+	}
+	fNumWritten += fNumPooled;
+	fNumPooled = 0;
+}
+
+void REDWriter::Close () {
+	if (!IsOpen())
+		return;
+	Flush();
+	fFile->AddRunInfo (fRunInfo);
+	fFile->Close();
+}
+
+// Basket holds the whole pool (at least default size), baskets are flushed
+// every FlushBytes, which is not less than one basket
+void REDWriter::Tune () {
+	TTree *Tree = 0;
+	TList *List = fDir ? fDir->GetList() : 0;
+	for (TObject *obj = List ? List->First() : 0; obj && !Tree; obj = List->After (obj))
+		Tree = dynamic_cast <TTree*> (obj);
+	if (!Tree)
+		return;
+	Long64_t Basket = GetEventSize() * fPool.size();
+	if (Basket < kMinBasket)
+		Basket = kMinBasket;
+	if (Basket > kMaxBasket)
+		Basket = kMaxBasket;
+	Long64_t FlushBytes = fFlushBytes;
+	if (!FlushBytes)
+		FlushBytes = kMinFlushBytes;
+	if (FlushBytes < Basket)
+		FlushBytes = Basket;
+	Tree->SetBasketSize ("*", Basket);
+	Tree->SetAutoFlush (-FlushBytes); // Negative - in bytes
+	if (fCompression >= 0) {
+		if (fDir->GetFile())
+			fDir->GetFile()->SetCompressionLevel (fCompression);
+		TObjArray *Branches = Tree->GetListOfBranches();
+		for (Int_t i = 0; i < Branches->GetEntriesFast(); i++)
+			((TBranch*) Branches->UncheckedAt(i))->SetCompressionLevel (fCompression);
+	}
+	fTuned = true;
+}
@@ -0,0 +1,74 @@
+#ifndef REDWriter_H
+#define REDWriter_H
+
+#include <vector>
+
+#include <Rtypes.h>
+#include <TDirectory.h>
+#include <TTree.h>
+
+#include <REDFile/File.hh>
+#include <REDEvent/Event.hh>
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Bulk writer of REDFile. Keeps pool of PoolSize events with the same     //
+// layout of waveforms (fData of each waveform is reserved for its number  //
+// of samples once), events are filled one after another and all of them   //
+// are handed to RED::OutputFile together when pool is full.               //
+//                                                                         //
+// Tree of file is tuned from the expected event size (sum of samples of   //
+// all waveforms): basket size holds the whole pool, baskets are flushed   //
+// to disk every FlushBytes (not per event), compression level of file     //
+// may be set. Tuning is applied when tree appears in file directory.      //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+class REDWriter
+{
+	public:
+
+		REDWriter (const char *filename, Int_t PoolSize = 64);
+		~REDWriter (); // Writes pooled events and run info, closes file
+
+	// SETTERS
+		// Add waveform to layout of all events, return its index
+		Int_t AddWaveform (Int_t Channel, Double_t Period, Double_t Gain, Int_t NumSamples, Double_t Delay);
+		void SetCompression (Int_t Level) {fCompression = Level;}  // ROOT compression level of file (-1 - keep default)
+		void SetFlushBytes (Long64_t Bytes) {fFlushBytes = Bytes;} // Flush baskets every Bytes (0 - from event size)
+
+	// GETTERS
+		Bool_t IsOpen ()                    {return fFile && fFile->IsOpen();}
+		RED::OutputFile* GetFile ()         {return fFile;}
+		RED::RunInfo* GetRunInfo ()         {return fRunInfo;}                         // Run info of file (set before Close)
+		RED::Event* GetEvent ()             {return fPool[fNumPooled];}                // Event being filled
+		RED::Waveform* GetWaveform (Int_t i) {return fWaveforms[fNumPooled][i];}       // Its waveform i
+		Int_t GetNumWaveforms ()            {return fLayout.size();}
+		Long64_t GetNumEvents ()            {return fNumWritten + fNumPooled;}         // Committed events
+		Long64_t GetEventSize ();           // Expected size of event, bytes
+
+	// ACTIONS
+		void Commit ();                     // Event being filled is complete, write pool if it is full
+		void Flush ();                      // Write all pooled events to file
+		void Close ();                      // Write pooled events and run info, close file
+
+	private:
+
+		void Tune (); // Set basket size, auto-flush and compression of tree
+
+		RED::OutputFile *fFile;
+		TDirectory *fDir;                      // Directory of file (where tree is created)
+		RED::RunInfo *fRunInfo;                // Run info of file and its events
+		vector <RED::Event*> fPool;
+		vector <vector <RED::Waveform*> > fWaveforms; // Waveforms of each pooled event
+		vector <Int_t> fLayout;                // Number of samples of each waveform
+		Int_t fNumPooled;                      // Events filled in pool
+		Long64_t fNumWritten;                  // Events handed to file
+		Int_t fCompression;
+		Long64_t fFlushBytes;
+		Bool_t fTuned;
+};
+
+#endif // REDWriter_H
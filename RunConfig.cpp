@@ -0,0 +1,375 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+#include <TF1.h>
+#include <TGraph.h>
+#include <TSpline.h>
+
+#include "RunConfig.h"
+
+using std::cout;
+using std::endl;
+using CLHEP::ns;
+using CLHEP::mV;
+
+// Defaults are the parameters of main.cpp
+static const char *kDefaults[][2] = {
+	// PMT
+	{"QE",            "0.3"},      // Quantum Efficiency (full)
+	{"Area_mean",     "60"},       // SPE pulse area, mV*ns
+	{"DCR",           "1e5"},      // Dark count rate, Hz
+	{"AP_cont",       "0"},        // Afterpulsing probability (continuum)
+	{"DPE_PC",        "0.225"},    // Double Photoelectron Emission probability for PC
+	{"DPE_1d",        "0.225"},    // Double Photoelectron Emission probability for 1dyn
+	{"QE_1d",         "0.105"},    // Quantum Efficiency for 1dyn
+	{"Gain_PC_1d",    "13"},       // Amplification on first gap (PC-1dyn)
+	{"GF_1d",         "0.1"},      // Geometric factor
+	{"TOFe_PC_1d",    "6"},        // ToF e- from PC to 1dyn, ns
+	{"TOFe_mean",     "30"},       // ToF e- from PC to anode, ns
+	{"TOFe_sigma",    "3"},        // Sigma of ToF PC-anode, ns
+	{"AP_peak",       "0"},        // Afterpulsing probability (peak)
+	{"Area_sigma",    "2"},        // Sigma of SPE area, mV*ns
+	// SPE shape: "gaus" (SPE_Width is FWHM) or "spline" (points taken from LED run)
+	{"SPE_Type",      "spline"},
+	{"SPE_Width",     "20"},
+	{"SPE_Xmin",      "-50"},
+	{"SPE_Xmax",      "50"},
+	{"SPE_SplineX",   "0 4 8 12 16 20 24 28 32 36 40 44 48 52 56 60"},
+	{"SPE_SplineY",   "-0.510066 -0.504701 -3.93614 -10.3283 -15.2794 -17.3102 -17.3881 -13.5405 -9.67392 -5.78841 -1.88383 -1.8855 -1.39651 -0.412552 0.0830006 -0.398009"},
+	// SPE area pdf (fit from Rudik presentation): two gaussians A*exp(-0.5*((x-x0)/sigma)^2)
+	// and exponential exp(A+kx) in range Area_FitBegin .. Area_FitEnd
+	{"Area_FitBegin", "60"},
+	{"Area_FitEnd",   "500"},
+	{"Area_Gaus1",    "3871 134.1 34.55"},
+	{"Area_Gaus2",    "194 287.3 39.16"},
+	{"Area_Exp",      "8.351 -6.687e-3"},
+	// Cache of precomputed tables (shape area, SPE area CDF, shape tables), "" - no cache
+	{"Cache",         ""},
+	// OutWave
+	{"Period",        "4"},        // ns
+	{"Gain",          "0.125"},    // mV
+	{"NumSamples",    "75000"},
+	{"Delay",         "-75000"},   // ns
+	// Run
+	{"Types",         "ER NR"},
+	{"MinPhotons",    "100"},
+	{"MaxPhotons",    "4000"},
+	{"StepPhotons",   "1"},
+	{"FracTime",      "90"},       // ns
+	{"PhotonWindow",  "0"},        // 1 - simulate only photons which may contribute to OutWave
+	{"BatchSize",     "1"},        // Number of events rendered together (WaveBatch)
+	{"Seed",          "1"},
+	{"Index",             "1"},    // 1 - write event index (OutName.idx) alongside output file
+	{"Write_Pool",        "64"},   // Events handed to REDFile together
+	{"Write_Compression", "-1"},   // ROOT compression level of REDFile (-1 - default)
+	{"Write_FlushMB",     "0"},    // Flush REDFile baskets every N MB (0 - from event size)
+	{"OutputMode",    "wave"},     // wave - REDFile, pulses - SPE only (PulseFile), both, seeds - config and event index only
+	{"Output_ER",     "ER.root"},
+	{"Output_NR",     "NR.root"},
+	{"Output_Hist",   "F90_hists.root"},
+	// Continuous stream (MakeWaveStream), photons number is uniform in MinPhotons .. MaxPhotons
+	{"Stream_Type",      "ER"},
+	{"Stream_Rate",      "1000"},       // Events rate, Hz
+	{"Stream_Duration",  "1e7"},        // ns
+	{"Stream_ChunkSize", "65536"},      // Samples in chunk
+	{"Output_Stream",    "stream.flat"} // Flat waveform file, one record per chunk
+};
+
+// Parameters of PMT model, tables derived from them are cached by GetModelKey
+static const char *kModelKeys[] = {
+	"QE", "Area_mean", "DCR", "AP_cont", "DPE_PC", "DPE_1d", "QE_1d", "Gain_PC_1d", "GF_1d",
+	"TOFe_PC_1d", "TOFe_mean", "TOFe_sigma", "AP_peak", "Area_sigma",
+	"SPE_Type", "SPE_Width", "SPE_Xmin", "SPE_Xmax", "SPE_SplineX", "SPE_SplineY",
+	"Area_FitBegin", "Area_FitEnd", "Area_Gaus1", "Area_Gaus2", "Area_Exp"
+};
+
+// SplitMix64 mixing function for deriving seeds
+static ULong64_t MixSeed (ULong64_t x) {
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+// TRandom3 uses 32 bits of seed and takes 0 as "random seed"
+static UInt_t SubSeed (ULong64_t Seed, Int_t n) {
+	UInt_t seed = MixSeed (Seed + n) & 0xFFFFFFFFULL;
+	return seed ? seed : 1;
+}
+
+RunConfig::RunConfig () {
+	fCache = 0;
+	for (unsigned int i = 0; i < sizeof(kDefaults)/sizeof(kDefaults[0]); i++)
+		fValues[kDefaults[i][0]] = kDefaults[i][1];
+}
+
+Bool_t RunConfig::ReadFile (const char *filename) {
+	std::ifstream file (filename);
+	if (!file.is_open()) {
+		cout << "ERROR. Config file " << filename << " can't be opened" << endl;
+		return false;
+	}
+	string line;
+	Int_t LineNum = 0;
+	while (std::getline (file, line)) {
+		LineNum++;
+		// Cut comment
+		size_t pos = line.find ('#');
+		if (pos != string::npos)
+			line.erase (pos);
+		if (line.find_first_not_of (" \t\r") == string::npos)
+			continue;
+		pos = line.find ('=');
+		if (pos == string::npos) {
+			cout << "ERROR. " << filename << ":" << LineNum << ": expected \"Key = Value\"" << endl;
+			return false;
+		}
+		string key   = line.substr (0, pos);
+		string value = line.substr (pos + 1);
+		key.erase (0, key.find_first_not_of (" \t"));
+		key.erase (key.find_last_not_of (" \t\r") + 1);
+		value.erase (0, value.find_first_not_of (" \t"));
+		value.erase (value.find_last_not_of (" \t\r") + 1);
+		SetValue (key.c_str(), value.c_str());
+	}
+	return true;
+}
+
+void RunConfig::SetValue (const char *key, const char *value) {
+	fValues[key] = value;
+}
+
+string RunConfig::GetString (const char *key) const {
+	std::map <string, string>::const_iterator it = fValues.find (key);
+	if (it == fValues.end()) {
+		cout << "ERROR. Parameter " << key << " is not set" << endl;
+		return "";
+	}
+	return it->second;
+}
+
+Double_t RunConfig::GetDouble (const char *key) const {
+	return atof (GetString(key).c_str());
+}
+
+vector <double> RunConfig::GetList (const char *key) const {
+	vector <double> list;
+	std::istringstream stream (GetString(key));
+	Double_t value;
+	while (stream >> value)
+		list.push_back (value);
+	return list;
+}
+
+vector <string> RunConfig::GetTypes () const {
+	vector <string> types;
+	std::istringstream stream (GetString("Types"));
+	string type;
+	while (stream >> type)
+		types.push_back (type);
+	return types;
+}
+
+ULong64_t RunConfig::GetModelKey () const {
+	CacheKey Key;
+	for (unsigned int i = 0; i < sizeof(kModelKeys)/sizeof(kModelKeys[0]); i++)
+		Key.Add (kModelKeys[i]).Add (GetString (kModelKeys[i]).c_str());
+	return Key.Get();
+}
+
+PrecompCache* RunConfig::GetCache () {
+	if (!fCache && GetString("Cache").size()) {
+		fCache = new PrecompCache;
+		if (!fCache->Open (GetString("Cache").c_str())) {
+			delete fCache;
+			fCache = 0;
+		}
+	}
+	return fCache;
+}
+
+Long64_t RunConfig::GetNumEvents () const {
+	Long64_t Step = GetInt("StepPhotons");
+	Long64_t Range = GetInt("MaxPhotons") - GetInt("MinPhotons");
+	if (Step <= 0 || Range <= 0)
+		return 0;
+	return (Range + Step - 1) / Step;
+}
+
+Int_t RunConfig::GetNumPhotons (Long64_t EventID) const {
+	return GetInt("MinPhotons") + EventID * GetInt("StepPhotons");
+}
+
+ULong64_t RunConfig::GetEventSeed (Int_t TypeIndex, Long64_t EventID) const {
+	ULong64_t RunSeed = strtoull (GetString("Seed").c_str(), 0, 10);
+	return MixSeed (MixSeed (RunSeed + TypeIndex) + EventID);
+}
+
+// Events are split into NumShards contiguous ranges, so merged shards keep order of events
+void RunConfig::GetShardRange (Int_t Shard, Int_t NumShards, Long64_t &First, Long64_t &Last) const {
+	Long64_t NumEvents = GetNumEvents();
+	First = NumEvents *  Shard      / NumShards;
+	Last  = NumEvents * (Shard + 1) / NumShards;
+}
+
+string RunConfig::GetOutName (const char *type) const {
+	return GetString ((string("Output_") + type).c_str());
+}
+
+string RunConfig::GetHistName () const {
+	return GetString ("Output_Hist");
+}
+
+// Pulse file name for REDFile name: ER.root -> ER_pulses.root
+string RunConfig::GetPulseName (const string &name) {
+	return name.substr (0, name.rfind (".root")) + "_pulses.root";
+}
+
+string RunConfig::GetShardName (const string &name, Int_t Shard, Int_t NumShards) {
+	std::ostringstream ShardName;
+	size_t pos = name.rfind (".root");
+	ShardName << name.substr (0, pos) << "_shard" << Shard << "of" << NumShards << ".root";
+	return ShardName.str();
+}
+
+RED::PMT_R11410* RunConfig::CreatePMT () {
+	RED::PMT_R11410 *pmt = new RED::PMT_R11410;
+	pmt->SetParams     (GetDouble("QE"), GetDouble("Area_mean")*mV*ns, GetDouble("DCR")/(1e9*ns), GetDouble("AP_cont"));
+	pmt->SetDPE_PC     (GetDouble("DPE_PC"));
+	pmt->SetDPE_1d     (GetDouble("DPE_1d"));
+	pmt->SetQE_1d      (GetDouble("QE_1d"));
+	pmt->SetGain_PC_1d (GetDouble("Gain_PC_1d"));
+	pmt->SetGF_1d      (GetDouble("GF_1d"));
+	pmt->SetTOFe_PC_1d (GetDouble("TOFe_PC_1d")*ns);
+	pmt->SetTOFe_mean  (GetDouble("TOFe_mean")*ns);
+	pmt->SetTOFe_sigma (GetDouble("TOFe_sigma")*ns);
+	pmt->SetAP_peak    (GetDouble("AP_peak"));
+	pmt->SetArea_sigma (GetDouble("Area_sigma")*mV*ns);
+
+	// SPE shape
+	if (GetString("SPE_Type") == "gaus") {
+		TF1 *func = new TF1("SPE","gaus(0)",GetDouble("SPE_Xmin")*ns,GetDouble("SPE_Xmax")*ns);
+		func->SetParameter (0, 1*mV); // Amplitude
+		func->SetParameter (1, 0*ns); // Center
+		func->SetParameter (2, GetDouble("SPE_Width")*ns/(2*sqrt(2*log(2)))); // Sigma
+		pmt->SetShape (func);
+	}
+	else {
+		vector <double> splx = GetList("SPE_SplineX");
+		vector <double> sply = GetList("SPE_SplineY");
+		Int_t splpoints = splx.size() < sply.size() ? splx.size() : sply.size();
+		for (int i = 0; i < splpoints; i++) {
+			splx[i] = splx[i] * ns;
+			sply[i] = sply[i] * mV;
+		}
+		TGraph* splgraph = new TGraph (splpoints,&splx[0],&sply[0]);
+		pmt->SetShape (new TSpline3 ("Spline shape",splgraph));
+	}
+
+	// SPE area pdf
+	Double_t fitbeg = GetDouble("Area_FitBegin")*mV*ns;
+	Double_t fitend = GetDouble("Area_FitEnd")*mV*ns;
+	vector <double> g1 = GetList("Area_Gaus1");
+	vector <double> g2 = GetList("Area_Gaus2");
+	vector <double> ex = GetList("Area_Exp");
+	if (g1.size() < 3 || g2.size() < 3 || ex.size() < 2) {
+		cout << "ERROR. Area_Gaus1, Area_Gaus2 need 3 values, Area_Exp needs 2 values" << endl;
+		return pmt;
+	}
+	char fitfunc[256] = "([0]*ROOT::Math::gaussian_pdf(x,[2],[1])+[3]*ROOT::Math::gaussian_pdf(x,[5],[4])+[6]*ROOT::Math::exponential_pdf(x,[7]))/[8]";
+	TF1 *SPEAreaPdf = new TF1 ("pdf for SPE Area",fitfunc,fitbeg,fitend);
+	Double_t p2 = g1[2]*mV*ns;
+	Double_t p5 = g2[2]*mV*ns;
+	Double_t p7 = ex[1]/(mV*ns);
+	SPEAreaPdf->SetParameter(0,g1[0]*sqrt(2*3.1415*p2*p2));
+	SPEAreaPdf->SetParameter(1,g1[1]*mV*ns);
+	SPEAreaPdf->SetParameter(2,p2);
+	SPEAreaPdf->SetParameter(3,g2[0]*sqrt(2*3.1415*p5*p5));
+	SPEAreaPdf->SetParameter(4,g2[1]*mV*ns);
+	SPEAreaPdf->SetParameter(5,p5);
+	SPEAreaPdf->SetParameter(6,exp(ex[0])/-p7);
+	SPEAreaPdf->SetParameter(7,-p7);
+	SPEAreaPdf->SetParameter(8,1); // Coeff for normalize function
+	PrecompCache *Cache = GetCache();
+	ULong64_t ModelKey = GetModelKey();
+	ULong64_t NormKey = CacheKey (ModelKey).Add ("AreaNorm").Get();
+	vector <double> Norm;
+	if (!Cache || !Cache->Get (NormKey, Norm, 1)) {
+		Norm.assign (1, SPEAreaPdf->Integral(fitbeg,fitend));
+		if (Cache)
+			Cache->Add (NormKey, Norm);
+	}
+	SPEAreaPdf->SetParameter(8,Norm[0]);
+	pmt->SetPdfAreaSPE (SPEAreaPdf);
+
+	pmt->SetCache (Cache, ModelKey); // Shape area and area CDF are taken from cache
+	pmt->CalculateParams();
+	return pmt;
+}
+
+MakeWave* RunConfig::CreateMakeWave (RED::PMT *pmt) {
+	MakeWave *MakeWaveObj = new MakeWave();
+	MakeWaveObj->SetPMT (pmt);
+	MakeWaveObj->SetOutWave (GetDouble("Period")*ns, GetDouble("Gain")*mV, GetInt("NumSamples"), GetDouble("Delay")*ns);
+	MakeWaveObj->SetFilePolicy (GetInt("Write_Pool"), GetInt("Write_Compression"), (Long64_t) (GetDouble("Write_FlushMB")*(1 << 20)));
+	return MakeWaveObj;
+}
+
+SimPhotons* RunConfig::CreateSimPhotons () {
+	SimPhotons *Photons = new SimPhotons();
+	Photons->SetDefFastFract();
+	return Photons;
+}
+
+void RunConfig::SetEventSeed (ULong64_t Seed, SimPhotons *Photons, RED::PMT *pmt, MakeWave *MakeWaveObj) {
+	if (Photons)
+		Photons->SetSeed (SubSeed (Seed, 0));
+	pmt->SetSeed (GetPMTSeed (Seed));
+	if (MakeWaveObj)
+		MakeWaveObj->SetSeed (GetMakeWaveSeed (Seed));
+}
+
+UInt_t RunConfig::GetPMTSeed (ULong64_t Seed) {
+	return SubSeed (Seed, 1);
+}
+
+UInt_t RunConfig::GetMakeWaveSeed (ULong64_t Seed) {
+	return SubSeed (Seed, 2);
+}
+
+Bool_t RunConfig::WriteWaves () const {
+	return GetString("OutputMode") != "pulses" && !WriteSeedsOnly();
+}
+
+Bool_t RunConfig::WritePulses () const {
+	return GetString("OutputMode") == "pulses" || GetString("OutputMode") == "both";
+}
+
+Bool_t RunConfig::WriteSeedsOnly () const {
+	return GetString("OutputMode") == "seeds";
+}
+
+Bool_t RunConfig::WriteFile (const char *filename) const {
+	std::ofstream file (filename);
+	if (!file.is_open()) {
+		cout << "ERROR. File " << filename << " can't be written" << endl;
+		return false;
+	}
+	file << ToString();
+	return file.good();
+}
+
+// All parameters in format of config file
+string RunConfig::ToString () const {
+	std::ostringstream text;
+	for (std::map <string, string>::const_iterator it = fValues.begin(); it != fValues.end(); it++)
+		text << it->first << " = " << it->second << endl;
+	return text.str();
+}
+
+void RunConfig::Print () const {
+	cout << "Run parameters:" << endl;
+	cout << ToString();
+}
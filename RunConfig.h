@@ -0,0 +1,90 @@
+#ifndef RunConfig_H
+#define RunConfig_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Rtypes.h>
+
+#include "MakeWave.h"
+#include "PMT_R11410.hh"
+#include "SimPhotons.h"
+#include "PrecompCache.h"
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Parameters of simulation run read from text config file.                //
+// Each line of file is "Key = Value" (lists are separated by spaces),     //
+// everything after '#' is a comment. Keys absent in file keep defaults    //
+// equal to parameters of main.cpp. Times are given in ns, amplitudes      //
+// in mV, areas in mV*ns and rates in Hz.                                  //
+//                                                                         //
+// Run consists of events of each interaction type from "Types" with       //
+// number of photons MinPhotons, MinPhotons+StepPhotons, ... < MaxPhotons. //
+// Each event has its own seed obtained from run "Seed", so any subset     //
+// of events (shard) is simulated the same way as in full run.             //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+using std::string;
+
+class RunConfig
+{
+	public:
+
+		RunConfig ();
+
+	// SETTERS
+		Bool_t ReadFile (const char *filename); // Read parameters from config file
+		void SetValue (const char *key, const char *value);
+
+	// GETTERS
+		string   GetString (const char *key) const;
+		Double_t GetDouble (const char *key) const;
+		Int_t    GetInt    (const char *key) const {return (Int_t) GetDouble(key);}
+		vector <double> GetList (const char *key) const;
+		vector <string> GetTypes () const; // Interaction types of run ("ER", "NR")
+
+		// Events of one interaction type
+		Long64_t GetNumEvents () const;                  // Number of events of each type
+		Int_t    GetNumPhotons (Long64_t EventID) const; // Number of photons in event
+		ULong64_t GetEventSeed (Int_t TypeIndex, Long64_t EventID) const; // Seed of event
+		// Events range [First, Last) of shard number Shard from NumShards
+		void GetShardRange (Int_t Shard, Int_t NumShards, Long64_t &First, Long64_t &Last) const;
+
+		// Precomputed tables
+		ULong64_t GetModelKey () const; // Hash of parameters of PMT model (SPE shape, SPE area pdf)
+		PrecompCache* GetCache ();      // Cache file "Cache" (opened at first call, 0 - no cache)
+
+		// Output files
+		string GetOutName  (const char *type) const;  // REDFile for interaction type
+		string GetHistName () const;                  // File for F90 histograms
+		Bool_t WriteWaves () const;                   // OutputMode is "wave" or "both"
+		Bool_t WritePulses () const;                  // OutputMode is "pulses" or "both"
+		Bool_t WriteSeedsOnly () const;               // OutputMode is "seeds" (only config and event index, see RunRegenerator)
+		Bool_t WriteFile (const char *filename) const; // Write all parameters to config file
+		static string GetPulseName (const string &name); // Pulse file for REDFile name
+		static string GetShardName (const string &name, Int_t Shard, Int_t NumShards); // name_shardKofN.root
+
+	// ACTIONS
+		RED::PMT_R11410* CreatePMT (); // Create PMT with SPE shape and SPE area pdf
+		MakeWave* CreateMakeWave (RED::PMT *pmt);
+		SimPhotons* CreateSimPhotons ();
+		static void SetEventSeed (ULong64_t Seed, SimPhotons *Photons, RED::PMT *pmt,
+		                          MakeWave *MakeWaveObj = 0); // Seed all generators for event (Photons = 0 - given photons)
+		static UInt_t GetPMTSeed (ULong64_t Seed);      // Seed of PMT for event (the same as set by SetEventSeed)
+		static UInt_t GetMakeWaveSeed (ULong64_t Seed); // Seed of MakeWave for event
+
+	// OUTPUT
+		string ToString () const; // All parameters in format of config file
+		void Print () const;
+
+	private:
+
+		std::map <string, string> fValues; // Values of parameters by keys
+		PrecompCache *fCache;              // Shared by copies of config, lives until the end of program
+};
+
+#endif // RunConfig_H
@@ -0,0 +1,46 @@
+#include <iostream>
+
+#include "RunRegenerator.h"
+
+using std::cout;
+using std::endl;
+
+RunRegenerator::RunRegenerator (const RunConfig &Config) : fConfig (Config) {
+	fPMT      = fConfig.CreatePMT();
+	fMakeWave = fConfig.CreateMakeWave (fPMT);
+	fPhotons  = fConfig.CreateSimPhotons();
+	if (fConfig.GetInt("PhotonWindow"))
+		fPhotons->SetWindow (fMakeWave);
+	fSeed = 0;
+}
+
+RunRegenerator::~RunRegenerator () {
+	delete fPhotons;
+	delete fMakeWave;
+	delete fPMT;
+}
+
+// The same steps as for event in MakeWaveBatch
+Bool_t RunRegenerator::RegenerateEvent (Int_t TypeIndex, Long64_t EventID) {
+	vector <string> Types = fConfig.GetTypes();
+	if (TypeIndex < 0 || TypeIndex >= (Int_t) Types.size() || EventID < 0 || EventID >= fConfig.GetNumEvents()) {
+		cout << "ERROR. Event " << EventID << " of type " << TypeIndex << " is absent in run" << endl;
+		return false;
+	}
+	fSeed = fConfig.GetEventSeed (TypeIndex, EventID);
+	RunConfig::SetEventSeed (fSeed, fPhotons, fPMT, fMakeWave);
+	fPhotonTimes = fPhotons->SimulatePhotons (fConfig.GetNumPhotons (EventID), Types[TypeIndex].c_str());
+	fMakeWave->SetPhotonTimes (&fPhotonTimes);
+	fMakeWave->CreateOutWave();
+	return true;
+}
+
+Bool_t RunRegenerator::RegenerateEvent (const char *type, Long64_t EventID) {
+	vector <string> Types = fConfig.GetTypes();
+	for (unsigned int t = 0; t < Types.size(); t++) {
+		if (Types[t] == type)
+			return RegenerateEvent (t, EventID);
+	}
+	cout << "ERROR. Type " << type << " is absent in run" << endl;
+	return false;
+}
@@ -0,0 +1,60 @@
+#ifndef RunRegenerator_H
+#define RunRegenerator_H
+
+#include <vector>
+
+#include <Rtypes.h>
+
+#include "MakeWave.h"
+#include "PMT_R11410.hh"
+#include "SimPhotons.h"
+#include "RunConfig.h"
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Regeneration of single events of run by event ID.                       //
+//                                                                         //
+// All generators used for event (SimPhotons, PMT, MakeWave) are seeded    //
+// from seed of event only (RunConfig::SetEventSeed), so event doesn't     //
+// depend on events simulated before it. Run stored only as its config     //
+// and event index (OutputMode = seeds) is enough to get photon times,     //
+// photoelectrons, dark counts and waveform of any event again exactly as  //
+// MakeWaveBatch simulated them. PMT and MakeWave are created once, so     //
+// each event takes only time of its own simulation.                       //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+class RunRegenerator
+{
+	public:
+
+		RunRegenerator (const RunConfig &Config); // Objects of run as MakeWaveBatch creates them
+		~RunRegenerator ();
+
+	// ACTIONS
+		Bool_t RegenerateEvent (Int_t TypeIndex, Long64_t EventID);    // TypeIndex - index in Types of config
+		Bool_t RegenerateEvent (const char *type, Long64_t EventID);
+
+	// GETTERS (of last regenerated event)
+		const vector <double>& GetPhotonTimes () {return fPhotonTimes;}
+		RED::PMT::PulseArray* GetPhotoElectrons () {return fMakeWave->GetPhotoElectrons();}
+		RED::PMT::PulseArray* GetDarkElectrons ()  {return fMakeWave->GetDarkElectrons();}
+		const vector <double>& GetOutWave () {return fMakeWave->GetOutWave();}
+		Int_t GetNumPE () {return fMakeWave->GetNumPE();}
+		ULong64_t GetSeed () {return fSeed;}
+		MakeWave* GetMakeWave () {return fMakeWave;} // Parameters of waveform, SPE shape
+		RunConfig& GetConfig () {return fConfig;}
+
+	private:
+
+		RunConfig fConfig;
+		RED::PMT_R11410 *fPMT;
+		MakeWave *fMakeWave;
+		SimPhotons *fPhotons;
+		vector <double> fPhotonTimes;
+		ULong64_t fSeed;          // Seed of last event
+};
+
+#endif // RunRegenerator_H
@@ -0,0 +1,52 @@
+#include "ShapeTable.h"
+#include "CPUDispatch.h"
+
+ShapeTable::ShapeTable (RED::PMT *pmt, Double_t Step) {
+	fPMT  = pmt;
+	fXmin = pmt->GetXmin();
+	fXmax = pmt->GetXmax();
+	fStep = Step;
+	Int_t NumPoints = ceil ((fXmax - fXmin) / fStep) + 1;
+	// Table of the same shape may be in cache of PMT
+	PrecompCache *Cache = pmt->GetCache();
+	ULong64_t Key = CacheKey (pmt->GetModelKey()).Add ("ShapeTable").Add (fStep).Get();
+	if (Cache && Cache->Get (Key, fTable, NumPoints + 1))
+		return;
+	fTable.resize (NumPoints + 1);
+	for (Int_t i = 0; i < NumPoints; i++) {
+		Double_t t = fXmin + i*fStep;
+		fTable[i] = t <= fXmax ? pmt->Eval(t) : pmt->Eval(fXmax);
+	}
+	fTable[NumPoints] = 0; // Guard point for interpolation at the right edge
+	if (Cache)
+		Cache->Add (Key, fTable);
+}
+
+Double_t ShapeTable::Eval (Double_t t) const {
+	if (t < fXmin || t > fXmax)
+		return 0;
+	Double_t x = (t - fXmin) / fStep;
+	Int_t i = x;
+	Double_t frac = x - i;
+	return fTable[i] + frac * (fTable[i+1] - fTable[i]);
+}
+
+MW_KERNEL void ShapeTable::AddPulse (Double_t *OutWave, Int_t NumSamples, Double_t Period,
+                                     Double_t PulseTime, Double_t Ampl) const {
+	// Left and right samples including SPE
+	Int_t StartSample  =  ceil ((PulseTime + fXmin) / Period);
+	Int_t FinishSample = floor ((PulseTime + fXmax) / Period);
+	if (StartSample < 0)
+		StartSample = 0;
+	if (FinishSample > NumSamples - 1)
+		FinishSample = NumSamples - 1;
+	// Position in table of first sample and step between samples in table units
+	Double_t x  = (StartSample*Period - PulseTime - fXmin) / fStep;
+	Double_t dx = Period / fStep;
+	const Double_t *Table = &fTable[0];
+	for (Int_t s = StartSample; s <= FinishSample; s++, x += dx) {
+		Int_t i = x;
+		Double_t frac = x - i;
+		OutWave[s] += Ampl * (Table[i] + frac * (Table[i+1] - Table[i]));
+	}
+}
@@ -1,6 +1,6 @@
 #include <iostream>
+#include <cmath>
 
-#include <TGraph.h>
 #include "SystemOfUnits.h"
 
 #include "SimPhotons.h"
@@ -16,10 +16,13 @@ SimPhotons::SimPhotons() {
 	fTauFast    = 6*ns;
 	fTauSlow    = 1500*ns;
 	SetFastFrac (0.22, 0.75);
-	gRandom->SetSeed(0);
-	fFastProbFunc = new TF1 ("pdf for fast fraction","ROOT::Math::binomial_pdf(x,[0],[1])",0,100);
-	fExpDecaySlow = new TF1 ("f_slow","exp(-x/[0])",0,100);
-	fExpDecayFast = new TF1 ("f_fast","exp(-x/[0])",0,100);
+	fRND.SetSeed(0);
+	fUseWindow    = false;
+	fWindowBegin  = 0;
+	fWindowEnd    = 0;
+	fNumSkipped   = 0;
+	fTotalSkipped = 0;
+	fTotalPhotons = 0;
 }
 
 void SimPhotons::SetTau (Double_t TauFast, Double_t TauSlow) {
@@ -27,6 +30,18 @@ void SimPhotons::SetTau (Double_t TauFast, Double_t TauSlow) {
 	fTauFast = TauSlow;
 }
 
+void SimPhotons::SetWindow (Double_t Begin, Double_t End) {
+	fUseWindow   = true;
+	fWindowBegin = Begin;
+	fWindowEnd   = End;
+}
+
+void SimPhotons::SetWindow (MakeWave *MakeWaveObj) {
+	Double_t Begin, End;
+	MakeWaveObj->GetPhotonWindow (Begin, End);
+	SetWindow (Begin, End);
+}
+
 void SimPhotons::SetFastFrac (TF1* FastER_func, TF1* FastNR_func) {
 	fFast_type = function;
 	fFastER_func = FastER_func;
@@ -58,22 +73,37 @@ vector <double> SimPhotons::SimulatePhotons(Int_t NumPhotons, Double_t FastFrac)
 
 vector <double> SimPhotons::SimulatePhotons(Int_t NumFast, Int_t NumSlow) {
 
-	// Set PDF of fast and slow scintillation decays
-	Double_t XmaxSlow = 30*fTauSlow;
-	fExpDecaySlow -> SetRange (0, XmaxSlow);
-	fExpDecaySlow -> SetParameter (0, fTauSlow);
-
-	Double_t XmaxFast = 30*fTauFast;
-	fExpDecayFast -> SetRange (0, XmaxFast);
-	fExpDecayFast -> SetParameter (0, fTauFast);
-
-	fSimPhotonTimes.clear();
-	// Get random tau for each photon
-	for (Int_t phe = 0; phe < NumFast; phe++){
-		fSimPhotonTimes.push_back(fExpDecayFast->GetRandom(0,XmaxFast));
+	// Fast and slow scintillation decays exp(-t/tau) are limited by 30*tau.
+	fTotalPhotons += NumFast + NumSlow;
+	fNumSkipped = 0;
+	if (fUseWindow) {
+		// Only photons in window, sampled from truncated exponential
+		Double_t FastBegin, FastEnd, SlowBegin, SlowEnd;
+		Int_t InFast = InWindow (NumFast, fTauFast, FastBegin, FastEnd);
+		Int_t InSlow = InWindow (NumSlow, fTauSlow, SlowBegin, SlowEnd);
+		fNumSkipped = NumFast + NumSlow - InFast - InSlow;
+		fTotalSkipped += fNumSkipped;
+		fSimPhotonTimes.resize (InFast + InSlow);
+		if (InFast)
+			SampleTruncated (&fSimPhotonTimes[0], InFast, fTauFast, FastBegin, FastEnd);
+		if (InSlow)
+			SampleTruncated (&fSimPhotonTimes[InFast], InSlow, fTauSlow, SlowBegin, SlowEnd);
+		return fSimPhotonTimes;
 	}
-	for (Int_t phe = 0; phe < NumSlow; phe++) {
-		fSimPhotonTimes.push_back(fExpDecaySlow->GetRandom(0,XmaxSlow));
+
+	// Times are sampled in batch from exponential distribution, rare
+	// times beyond the limit (probability exp(-30)) are sampled again
+	fSimPhotonTimes.resize (NumFast + NumSlow);
+	if (!fSimPhotonTimes.size())
+		return fSimPhotonTimes;
+	if (NumFast > 0)
+		fRND.FillExp (&fSimPhotonTimes[0], NumFast, fTauFast);
+	if (NumSlow > 0)
+		fRND.FillExp (&fSimPhotonTimes[NumFast], NumSlow, fTauSlow);
+	for (Int_t phe = 0; phe < NumFast + NumSlow; phe++) {
+		Double_t Tau = phe < NumFast ? fTauFast : fTauSlow;
+		while (fSimPhotonTimes[phe] > 30 * Tau)
+			fSimPhotonTimes[phe] = fRND.Exp (Tau);
 	}
 
 	return fSimPhotonTimes;
@@ -98,14 +128,33 @@ vector <double> SimPhotons::SimulatePhotons (Int_t NumPhotons, Option_t* type) {
 		cout << "Please set \"NR\" or \"ER\" as interaction type" << endl;
 
 	// Simulate number of fast photons
-	fFastProbFunc -> SetRange (0, NumPhotons+1);
-	fFastProbFunc -> SetParameter (0, FastProb);
-	fFastProbFunc -> SetParameter (1, NumPhotons);
-	Int_t NumFast = round (fFastProbFunc -> GetRandom (0, NumPhotons+1));
+	Int_t NumFast = fRND.Binomial (NumPhotons, FastProb);
 
 
 	// Simulate photons
 	Int_t NumSlow = NumPhotons - NumFast;
 	SimulatePhotons (NumFast, NumSlow);
 	return fSimPhotonTimes;
-}
\ No newline at end of file
+}
+
+// Window intersected with [0, 30*tau]: probability for photon to be inside is
+// (exp(-Begin/tau) - exp(-End/tau)) / (1 - exp(-30))
+Int_t SimPhotons::InWindow (Int_t Num, Double_t Tau, Double_t &Begin, Double_t &End) {
+	Begin = std::max (fWindowBegin, 0.);
+	End   = std::min (fWindowEnd, 30 * Tau);
+	if (Num <= 0 || Begin >= End)
+		return 0;
+	Double_t Prob = (exp (-Begin/Tau) - exp (-End/Tau)) / (1 - exp (-30.));
+	if (Prob >= 1)
+		return Num;
+	return fRND.Binomial (Num, Prob);
+}
+
+// Inversion of exponential CDF truncated to [Begin, End):
+// t = Begin - tau * ln(1 - RND * (1 - exp(-(End-Begin)/tau)))
+void SimPhotons::SampleTruncated (Double_t *Times, Int_t Num, Double_t Tau, Double_t Begin, Double_t End) {
+	fRND.FillUniform (Times, Num);
+	Double_t Norm = -expm1 (-(End - Begin) / Tau);
+	for (Int_t phe = 0; phe < Num; phe++)
+		Times[phe] = Begin - Tau * log1p (-Times[phe] * Norm);
+}
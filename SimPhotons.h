@@ -10,13 +10,10 @@
 #include <TH1.h>
 #include <TF1.h>
 #include <TSpline.h>
-#include <TRandom3.h>
 #include "SystemOfUnits.h"
-#include <TApplication.h>
-#include <TCanvas.h>
-#include <TGraph.h>
 
 #include "MakeWave.h"
+#include "BulkRNG.h"
 
 ///////////////////////////////////////////////////////////////////////////////////////
 //                                                                                   //
@@ -29,6 +26,10 @@
 // After setting parameters of scintillation and interaction                         //
 // user can get vector of photons times, where interaction happened at "0" point.    //
 //                                                                                   //
+// In window mode only photons inside window (e.g. photons which may contribute      //
+// to waveform of MakeWave) are simulated: their number is binomial and times are    //
+// sampled from exponential truncated to window. Others are only counted.            //
+//                                                                                   //
 ///////////////////////////////////////////////////////////////////////////////////////
 
 using std::vector;
@@ -47,9 +48,19 @@ class SimPhotons
 		void SetFastFrac (TF1* FastER_func, TF1* FastNR_func);  // as functions depend on photons number
 		void SetFastFrac (Double_t FastER, Double_t FastNR);    // as constants
 		void SetDefFastFract (); // Set fast fractions as (A + B / NumPhotons) with default A,B for ER & NR
+		void SetSeed (UInt_t Seed) {fRND.SetSeed(Seed);} // Seed of random generator (0 - random seed)
+		void SetWindow (Double_t Begin, Double_t End); // Simulate only photons with times in [Begin, End)
+		void SetWindow (MakeWave *MakeWaveObj);        // Window of photons contributing to waveforms of MakeWaveObj
+		void ClearWindow () {fUseWindow = false;}      // Simulate all photons
 		
 	// GETTERS
 		vector <double> GetSimPhotonTimes() {return fSimPhotonTimes;} // return vector of photons times
+		Bool_t   IsWindow ()         {return fUseWindow;}
+		Double_t GetWindowBegin ()   {return fUseWindow ? fWindowBegin : 0;}
+		Double_t GetWindowEnd ()     {return fUseWindow ? fWindowEnd : 0;}
+		Int_t    GetNumSkipped ()    {return fNumSkipped;}    // Photons outside window in last event
+		Long64_t GetTotalSkipped ()  {return fTotalSkipped;}  // Photons outside window in all events
+		Long64_t GetTotalPhotons ()  {return fTotalPhotons;}  // All photons (simulated and skipped) in all events
 		
 	// ACTIONS
 		// Simulate flashing times
@@ -58,6 +69,9 @@ class SimPhotons
 		vector <double> SimulatePhotons (Int_t NumPhotons, Option_t* type);
 
 	private:
+
+		Int_t InWindow (Int_t Num, Double_t Tau, Double_t &Begin, Double_t &End); // Number of photons of component in window, range of their times
+		void SampleTruncated (Double_t *Times, Int_t Num, Double_t Tau, Double_t Begin, Double_t End); // Exponential times in [Begin, End)
 	
 		// Auxiliary		
 		enum func_type {constant, function} fFast_type; // Show if fast Sc fraction depends on photons number
@@ -72,9 +86,13 @@ class SimPhotons
 		Double_t fFastNR;   // The same for NR
 		TF1* fFastER_func;  // Fraction of fast component for Sc from ER depends on photons number
 		TF1* fFastNR_func;  // The same for NR
-		TF1* fExpDecaySlow; // decay PDF of slow Sc component
-		TF1* fExpDecayFast; // decay PDF of fast Sc component
-		TF1* fFastProbFunc; // binomial PDF for fast fraction
+		BulkRNG fRND;       // Object for random calculations (own, so SimPhotons may run in separate thread)
+		Bool_t   fUseWindow;    // Simulate only photons in window
+		Double_t fWindowBegin;
+		Double_t fWindowEnd;
+		Int_t    fNumSkipped;   // Photons outside window in last event
+		Long64_t fTotalSkipped;
+		Long64_t fTotalPhotons;
 		
 		// Output
 		vector <double> fSimPhotonTimes; // Output vector of photons arrival times
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include "StreamWave.h"
+
+using std::cout;
+using std::endl;
+
+StreamWave::StreamWave (RED::PMT *pmt, SimPhotons *Photons) {
+	fPMT        = pmt;
+	fPhotons    = Photons;
+	fShape      = new ShapeTable (pmt);
+	fSink       = 0;
+	fRate       = 0;
+	fType       = "ER";
+	fMinPhotons = 100;
+	fMaxPhotons = 100;
+	fRND.SetSeed(0);
+	SetOutWave (4*ns, 1, 65536);
+}
+
+StreamWave::~StreamWave () {
+	delete fShape;
+}
+
+void StreamWave::SetRate (Double_t Rate) {
+	fRate = Rate;
+	Start();
+}
+
+void StreamWave::SetEvents (const char *Type, Int_t MinPhotons, Int_t MaxPhotons) {
+	fType       = Type;
+	fMinPhotons = MinPhotons;
+	fMaxPhotons = MaxPhotons > MinPhotons ? MaxPhotons : MinPhotons;
+}
+
+void StreamWave::SetOutWave (Double_t Period, Double_t Gain, Int_t ChunkSize) {
+	fPeriod    = Period;
+	fGain      = Gain;
+	fChunkSize = ChunkSize;
+	fTailSize  = ceil ((fShape->GetXmax() - fShape->GetXmin()) / fPeriod) + 1;
+	fLookAhead = fShape->GetXmin() < 0 ? -fShape->GetXmin() : 0;
+	Start();
+}
+
+void StreamWave::SetSeed (UInt_t Seed) {
+	fRND.SetSeed (Seed);
+	fPhotons->SetSeed (fRND.Integer (0xFFFFFFFF) + 1);
+	fPMT->SetSeed (fRND.Integer (0xFFFFFFFF) + 1);
+}
+
+void StreamWave::Start () {
+	fBuffer.assign (fChunkSize + fTailSize, 0);
+	fSpare.assign (fChunkSize + fTailSize, 0);
+	fPending.clear();
+	fNextEvent  = fRate > 0 ? fRND.Exp (1/fRate) : 0;
+	fHorizon    = 0;
+	fNumChunks  = 0;
+	fNumEvents  = 0;
+	fNumPulses  = 0;
+	fMaxPending = 0;
+}
+
+// Events arriving before Horizon and dark counts between previous and new Horizon
+void StreamWave::GenEvents (Double_t Horizon) {
+	while (fRate > 0 && fNextEvent < Horizon) {
+		Int_t NumPhotons = fMinPhotons + fRND.Integer (fMaxPhotons - fMinPhotons + 1);
+		const vector <double> &Times = fPhotons->SimulatePhotons (NumPhotons, fType.c_str());
+		if (Times.size())
+			fPMT->ManyPhotons (&Times[0], Times.size(), fPending, fNextEvent);
+		fNumEvents++;
+		fNextEvent += fRND.Exp (1/fRate);
+	}
+	if (Horizon > fHorizon)
+		fPMT->GenDCR (fHorizon, Horizon, fPending);
+	fHorizon = Horizon;
+}
+
+const Double_t* StreamWave::NextChunk () {
+	Double_t ChunkTime = fChunkSize * fPeriod;
+	// Pulses of photons arriving up to the end of chunk may start in it
+	GenEvents (ChunkTime + fLookAhead);
+
+	// Render pulses starting in this chunk (their tails fit into buffer), keep others
+	unsigned int NumKept = 0;
+	for (unsigned int i = 0; i < fPending.size(); i++) {
+		const RED::PMT::Pulse &Pulse = fPending[i];
+		if (Pulse.fTime + fShape->GetXmin() < ChunkTime) {
+			fShape->AddPulse (&fBuffer[0], fBuffer.size(), fPeriod, Pulse.fTime, Pulse.fAmpl/fGain);
+			fNumPulses++;
+		}
+		else
+			fPending[NumKept++] = Pulse;
+	}
+	fPending.resize (NumKept);
+	if ((Int_t) NumKept > fMaxPending)
+		fMaxPending = NumKept;
+
+	// Emit chunk, tail goes to the beginning of the next buffer
+	std::copy (fBuffer.begin() + fChunkSize, fBuffer.end(), fSpare.begin());
+	std::fill (fSpare.begin() + fTailSize, fSpare.end(), 0);
+	fBuffer.swap (fSpare);
+	if (fSink)
+		fSink->Write (fNumChunks * fChunkSize, &fSpare[0], fChunkSize);
+	fNumChunks++;
+
+	// Shift times to the beginning of the next chunk
+	for (unsigned int i = 0; i < fPending.size(); i++)
+		fPending[i].fTime -= ChunkTime;
+	fNextEvent -= ChunkTime;
+	fHorizon   -= ChunkTime;
+	return &fSpare[0];
+}
+
+void StreamWave::Run (Double_t Duration) {
+	while (GetTime() < Duration)
+		NextChunk();
+}
@@ -0,0 +1,128 @@
+#ifndef StreamWave_H
+#define StreamWave_H
+
+#include <vector>
+#include <string>
+
+#include <Rtypes.h>
+#include <TRandom3.h>
+#include "SystemOfUnits.h"
+
+#include "PMT_R11410.hh"
+#include "SimPhotons.h"
+#include "ShapeTable.h"
+#include "FlatWaveFile.h"
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Free-running digitizer stream. Events arrive as Poisson process with    //
+// given rate, their pulses overlap with tails of previous events and with //
+// continuous dark counts.                                                 //
+//                                                                         //
+// Stream is rendered by chunks of fixed number of samples into buffer of  //
+// chunk + tail (length of SPE shape) samples. Pulses starting in current  //
+// chunk are rendered completely, the tail part is carried over to the     //
+// next buffer. Pulses starting later wait in pending list. So memory use  //
+// does not depend on duration of stream. Times are kept relative to the   //
+// beginning of current chunk.                                             //
+//                                                                         //
+// Each ready chunk is passed to StreamSink.                               //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+using std::string;
+using CLHEP::ns;
+
+// Receiver of stream chunks
+class StreamSink
+{
+	public:
+
+		virtual ~StreamSink () { ; }
+		// Chunk of NumSamples samples, the first one has number FirstSample in stream
+		virtual void Write (Long64_t FirstSample, const Double_t *Samples, Int_t NumSamples) = 0;
+};
+
+// Sink writing each chunk as waveform record of flat file (EventID - number of chunk)
+class FlatStreamSink : public StreamSink
+{
+	public:
+
+		FlatStreamSink (FlatWaveWriter *Writer, Double_t Period, Double_t Gain) :
+			fWriter(Writer), fPeriod(Period), fGain(Gain) { ; }
+		void Write (Long64_t FirstSample, const Double_t *Samples, Int_t NumSamples) {
+			fWriter->AddWaveform (FirstSample / NumSamples, 0, Samples, NumSamples, fPeriod, fGain, FirstSample * fPeriod);
+		}
+
+	private:
+
+		FlatWaveWriter *fWriter;
+		Double_t fPeriod;
+		Double_t fGain;
+};
+
+class StreamWave
+{
+	public:
+
+		StreamWave (RED::PMT *pmt, SimPhotons *Photons);
+		~StreamWave ();
+
+	// SETTERS
+		void SetRate (Double_t Rate); // Events rate (1/ns)
+		void SetEvents (const char *Type, Int_t MinPhotons, Int_t MaxPhotons); // Interaction type and range of photons number (uniform)
+		void SetOutWave (Double_t Period, Double_t Gain, Int_t ChunkSize); // Sampling, ADC resolution and samples in chunk
+		void SetSink (StreamSink *Sink) {fSink = Sink;}
+		void SetSeed (UInt_t Seed); // Seed of arrivals, photons and PMT generators
+
+	// GETTERS
+		Double_t GetTime ()        {return fNumChunks * fChunkSize * fPeriod;} // Duration of stream generated
+		Int_t    GetChunkSize ()   {return fChunkSize;}
+		Long64_t GetNumChunks ()   {return fNumChunks;}
+		Long64_t GetNumEvents ()   {return fNumEvents;}
+		Long64_t GetNumPulses ()   {return fNumPulses;}   // Rendered SPE (photons and dark counts)
+		Int_t    GetMaxPending ()  {return fMaxPending;}  // Maximum size of pending list
+
+	// ACTIONS
+		void Start (); // Reset stream to time 0 (called by SetRate and SetOutWave)
+		const Double_t* NextChunk (); // Generate next chunk of GetChunkSize() samples (also passed to sink), valid until next call
+		void Run (Double_t Duration); // Generate chunks until Duration of stream
+
+	private:
+
+		void GenEvents (Double_t Horizon); // Generate events and dark counts up to Horizon
+
+		// Sources
+		RED::PMT *fPMT;
+		SimPhotons *fPhotons;
+		ShapeTable *fShape;
+		StreamSink *fSink;
+		TRandom3 fRND;           // Arrivals and photons numbers
+
+		// Parameters
+		Double_t fRate;
+		string   fType;
+		Int_t    fMinPhotons;
+		Int_t    fMaxPhotons;
+		Double_t fPeriod;
+		Double_t fGain;
+		Int_t    fChunkSize;
+		Int_t    fTailSize;      // Samples of SPE shape length
+		Double_t fLookAhead;     // Pulses may start this time before photon (left part of SPE shape)
+
+		// State (times from the beginning of current chunk)
+		vector <double> fBuffer;            // Chunk + tail
+		vector <double> fSpare;             // Next buffer (swapped with fBuffer after each chunk)
+		RED::PMT::PulseArray fPending;      // Pulses not yet rendered
+		Double_t fNextEvent;                // Arrival of next event
+		Double_t fHorizon;                  // Events and dark counts are generated up to this time
+
+		// Statistics
+		Long64_t fNumChunks;
+		Long64_t fNumEvents;
+		Long64_t fNumPulses;
+		Int_t    fMaxPending;
+};
+
+#endif // StreamWave_H
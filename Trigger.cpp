@@ -0,0 +1,141 @@
+#include <iostream>
+#include <algorithm>
+
+#include "Trigger.h"
+
+using std::cout;
+using std::endl;
+
+static const Int_t kBlock = 16; // Samples in block checked at once
+
+Trigger::Trigger () {
+	SetThreshold (10, -1);
+	fBaseline = 0;
+	SetCoincidence (100*ns, 1);
+	SetPrePost (1000, 4000);
+	fDeadTime = 0;
+	fROIDead  = true;
+	ResetStats();
+}
+
+void Trigger::SetThreshold (Double_t Threshold, Int_t Polarity) {
+	fThreshold = Threshold;
+	fPolarity  = Polarity < 0 ? -1 : 1;
+}
+
+void Trigger::SetCoincidence (Double_t Window, Int_t Majority) {
+	fWindow   = Window;
+	fMajority = Majority;
+}
+
+void Trigger::SetPrePost (Int_t PreSamples, Int_t PostSamples) {
+	fPreSamples  = PreSamples;
+	fPostSamples = PostSamples;
+}
+
+void Trigger::ResetStats () {
+	fNumEvents   = 0;
+	fNumTriggers = 0;
+	fTotalTime   = 0;
+	fDeadTimeSum = 0;
+}
+
+Int_t Trigger::FindCrossing (const Double_t *Wave, Int_t From, Int_t NumSamples) {
+	// Signal above threshold: Polarity*sample > Polarity*Baseline + Threshold
+	Double_t Sign = fPolarity;
+	Double_t Cut  = fPolarity * fBaseline + fThreshold;
+	Int_t i = From;
+	// Skip blocks of baseline
+	while (i + kBlock <= NumSamples) {
+		Double_t Max = Sign * Wave[i];
+		for (Int_t k = 1; k < kBlock; k++) {
+			Double_t s = Sign * Wave[i + k];
+			Max = s > Max ? s : Max;
+		}
+		if (Max > Cut)
+			break;
+		i += kBlock;
+	}
+	for (; i < NumSamples; i++)
+		if (Sign * Wave[i] > Cut)
+			return i;
+	return -1;
+}
+
+Int_t Trigger::FindRearm (const Double_t *Wave, Int_t From, Int_t NumSamples) {
+	Double_t Sign = fPolarity;
+	Double_t Cut  = fPolarity * fBaseline + fThreshold;
+	for (Int_t i = From; i < NumSamples; i++)
+		if (Sign * Wave[i] <= Cut)
+			return i;
+	return -1;
+}
+
+Bool_t Trigger::Process (const Double_t* const *Waves, Int_t NumWaves, Int_t NumSamples, Double_t Period,
+                         Int_t &First, Int_t &Last) {
+	fNumEvents++;
+	fTotalTime += NumSamples * Period;
+	Int_t TrigSample = -1;
+
+	if (fMajority <= 1) {
+		// Earliest crossing of any channel
+		for (Int_t w = 0; w < NumWaves; w++) {
+			Int_t Crossing = FindCrossing (Waves[w], 0, TrigSample < 0 ? NumSamples : TrigSample);
+			if (Crossing >= 0)
+				TrigSample = Crossing;
+		}
+	}
+	else {
+		// All crossings of all channels, sorted by time
+		fCrossings.clear();
+		for (Int_t w = 0; w < NumWaves; w++) {
+			Int_t Crossing = FindCrossing (Waves[w], 0, NumSamples);
+			while (Crossing >= 0) {
+				fCrossings.push_back (std::make_pair (Crossing, w));
+				Int_t Rearm = FindRearm (Waves[w], Crossing, NumSamples);
+				if (Rearm < 0)
+					break;
+				Crossing = FindCrossing (Waves[w], Rearm, NumSamples);
+			}
+		}
+		std::sort (fCrossings.begin(), fCrossings.end());
+		// Sliding coincidence window: count channels with crossings in it
+		Int_t WindowSamples = fWindow / Period;
+		fChannelCount.assign (NumWaves, 0);
+		Int_t NumFired = 0;
+		unsigned int lo = 0;
+		for (unsigned int hi = 0; hi < fCrossings.size(); hi++) {
+			if (fChannelCount[fCrossings[hi].second]++ == 0)
+				NumFired++;
+			while (fCrossings[hi].first - fCrossings[lo].first > WindowSamples)
+				if (--fChannelCount[fCrossings[lo++].second] == 0)
+					NumFired--;
+			if (NumFired >= fMajority) {
+				TrigSample = fCrossings[hi].first;
+				break;
+			}
+		}
+	}
+	if (TrigSample < 0)
+		return false;
+
+	First = std::max (0, TrigSample - fPreSamples);
+	Last  = std::min (NumSamples, TrigSample + fPostSamples);
+	fNumTriggers++;
+	fDeadTimeSum += fDeadTime + (fROIDead ? (Last - First) * Period : 0);
+	return true;
+}
+
+Bool_t Trigger::Process (const vector <double> &Wave, Double_t Period, Int_t &First, Int_t &Last) {
+	const Double_t *Waves[1] = {Wave.size() ? &Wave[0] : 0};
+	return Process (Waves, 1, Wave.size(), Period, First, Last);
+}
+
+void Trigger::PrintStats () {
+	cout << "Trigger: " << fNumTriggers << " of " << fNumEvents << " events";
+	if (fNumEvents)
+		cout << " (" << 100. * fNumTriggers / fNumEvents << " %)";
+	cout << endl;
+	cout << "  Rate        = " << GetRate() * (1e9*ns) << " Hz of " << fTotalTime/ns << " ns" << endl;
+	cout << "  Dead time   = " << fDeadTimeSum/ns << " ns (" << 100. * GetDeadFraction() << " %)" << endl;
+}
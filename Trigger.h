@@ -0,0 +1,89 @@
+#ifndef Trigger_H
+#define Trigger_H
+
+#include <vector>
+
+#include <Rtypes.h>
+#include "SystemOfUnits.h"
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Software trigger for generated waveforms.                               //
+// Channel fires when signal (Polarity * (sample - Baseline)) rises above  //
+// Threshold. Event is triggered when at least Majority channels fire      //
+// within coincidence window; trigger sample is the crossing completing    //
+// the coincidence. Region of interest (ROI) is PreSamples before and      //
+// PostSamples after trigger sample.                                       //
+//                                                                         //
+// Waveform is scanned by blocks: only blocks whose maximum exceeds        //
+// threshold are searched sample by sample, so baseline (the most of       //
+// waveform) is passed with simple vectorizable loop.                      //
+//                                                                         //
+// Statistics: trigger rate relative to total time of processed windows,   //
+// dead time = readout dead time of each trigger plus ROI length, since    //
+// digitizer without multi-event buffer can't trigger while it records     //
+// ROI (SetDeadTime with ROIDead = false for dead-timeless readout).       //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+using CLHEP::ns;
+
+class Trigger
+{
+	public:
+
+		Trigger ();
+
+	// SETTERS
+		void SetThreshold (Double_t Threshold, Int_t Polarity = -1); // Threshold in ADC units, Polarity -1 for negative pulses
+		void SetBaseline (Double_t Baseline) {fBaseline = Baseline;} // Baseline in ADC units
+		void SetCoincidence (Double_t Window, Int_t Majority = 1);  // Majority of channels firing within Window
+		void SetPrePost (Int_t PreSamples, Int_t PostSamples);       // Samples of ROI before and after trigger
+		// Readout dead time after ROI, ROIDead - time of ROI itself is dead too (no multi-event buffer)
+		void SetDeadTime (Double_t DeadTime, Bool_t ROIDead = true) {fDeadTime = DeadTime; fROIDead = ROIDead;}
+
+	// GETTERS
+		Long64_t GetNumEvents ()   {return fNumEvents;}
+		Long64_t GetNumTriggers () {return fNumTriggers;}
+		Double_t GetTotalTime ()   {return fTotalTime;}  // Total time of processed windows
+		Double_t GetRate ()        {return fTotalTime > 0 ? fNumTriggers / fTotalTime : 0;} // Triggers per unit time
+		Double_t GetDeadFraction () {return fTotalTime > 0 ? fDeadTimeSum / fTotalTime : 0;}
+
+	// ACTIONS
+		// Decide for event of NumWaves channels with NumSamples samples each.
+		// If event is triggered, ROI [First, Last) is returned
+		Bool_t Process (const Double_t* const *Waves, Int_t NumWaves, Int_t NumSamples, Double_t Period,
+		                Int_t &First, Int_t &Last);
+		Bool_t Process (const vector <double> &Wave, Double_t Period, Int_t &First, Int_t &Last); // Single channel
+		Int_t FindCrossing (const Double_t *Wave, Int_t From, Int_t NumSamples); // First crossing at or after From (-1 if none)
+		void ResetStats ();
+		void PrintStats ();
+
+	private:
+
+		Int_t FindRearm (const Double_t *Wave, Int_t From, Int_t NumSamples); // First sample below threshold
+
+		// Parameters
+		Double_t fThreshold;
+		Int_t    fPolarity;
+		Double_t fBaseline;
+		Double_t fWindow;
+		Int_t    fMajority;
+		Int_t    fPreSamples;
+		Int_t    fPostSamples;
+		Double_t fDeadTime;
+		Bool_t   fROIDead;
+
+		// Crossings of all channels (sample, channel)
+		vector <std::pair <Int_t, Int_t> > fCrossings;
+		vector <Int_t> fChannelCount; // Crossings of each channel in coincidence window
+
+		// Statistics
+		Long64_t fNumEvents;
+		Long64_t fNumTriggers;
+		Double_t fTotalTime;
+		Double_t fDeadTimeSum;
+};
+
+#endif // Trigger_H
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "WaveBatch.h"
+#include "MakeWave.h"
+#include "ElecChain.h"
+
+using std::cout;
+using std::endl;
+
+static const Int_t kRowAlign = 64 / sizeof(Double_t); // Samples in 64 bytes
+
+WaveBatch::WaveBatch (MakeWave *MakeWaveObj, Int_t MaxEvents) {
+	fMakeWave   = MakeWaveObj;
+	fMaxEvents  = MaxEvents > 0 ? MaxEvents : 1;
+	fNumEvents  = 0;
+	fNumSamples = 0;
+	fStride     = 0;
+	fData       = 0;
+	fTimes.resize (fMaxEvents);
+	fSeeds.resize (fMaxEvents);
+	fNoiseSeeds.resize (fMaxEvents);
+	fPhotoElectrons.resize (fMaxEvents);
+	fDarkElectrons.resize (fMaxEvents);
+	Allocate();
+}
+
+WaveBatch::~WaveBatch () {
+	free (fData);
+	for (unsigned int t = 0; t < fNoiseRND.size(); t++)
+		delete fNoiseRND[t];
+}
+
+void WaveBatch::Allocate () {
+	Int_t NumSamples = fMakeWave->GetNumSamples();
+	if (fData && NumSamples == fNumSamples)
+		return;
+	free (fData);
+	fNumSamples = NumSamples;
+	fStride     = (fNumSamples + kRowAlign - 1) / kRowAlign * kRowAlign;
+	if (posix_memalign ((void**) &fData, 64, (size_t) fMaxEvents * fStride * sizeof(Double_t))) {
+		cout << "ERROR. Buffer for batch of " << fMaxEvents << " events can't be allocated" << endl;
+		fData = 0;
+		fMaxEvents = 0;
+	}
+}
+
+Int_t WaveBatch::AddEvent (const Double_t *Times, Int_t NumPhotons, UInt_t PMTSeed, UInt_t Seed) {
+	if (fNumEvents >= fMaxEvents)
+		return -1;
+	fTimes[fNumEvents].assign (Times, Times + NumPhotons);
+	fSeeds[fNumEvents] = PMTSeed;
+	// Noise of event depends only on its seed, not on thread which renders it
+	fNoiseSeeds[fNumEvents] = MakeWave::GetNoiseSeed (Seed ? Seed : fSeedRND.Integer (kMaxInt));
+	return fNumEvents++;
+}
+
+void WaveBatch::Render () {
+	Allocate(); // OutWave parameters may be changed since last batch
+	if (!fData)
+		return;
+
+	// Pass 1: SPE of all events
+	for (Int_t ev = 0; ev < fNumEvents; ev++) {
+		if (fSeeds[ev])
+			fMakeWave->GetPMT()->SetSeed (fSeeds[ev]);
+		fMakeWave->GenElectrons (fTimes[ev].size() ? &fTimes[ev][0] : 0, fTimes[ev].size(),
+		                         fPhotoElectrons[ev], fDarkElectrons[ev]);
+	}
+
+	// Pass 2: waveforms
+	memset (fData, 0, (size_t) fNumEvents * fStride * sizeof(Double_t));
+	Int_t NumThreads = fMakeWave->GetNumThreads();
+	if (NumThreads > fNumEvents)
+		NumThreads = fNumEvents;
+	if (NumThreads < 1)
+		NumThreads = 1;
+	while ((Int_t) fNoiseRND.size() < NumThreads)
+		fNoiseRND.push_back (new TRandom3 (1)); // Seeded for each event
+	if (NumThreads == 1) {
+		RenderRows (0, 1);
+		return;
+	}
+	fMakeWave->GetPMT()->SetNumThreads (NumThreads);
+	if (fMakeWave->GetElecChain())
+		fMakeWave->GetElecChain()->SetNumThreads (NumThreads);
+	vector <std::thread> Threads;
+	for (Int_t t = 0; t < NumThreads; t++)
+		Threads.push_back (std::thread (&WaveBatch::RenderRows, this, t, NumThreads));
+	for (Int_t t = 0; t < NumThreads; t++)
+		Threads[t].join();
+}
+
+void WaveBatch::RenderRows (Int_t First, Int_t Step) {
+	for (Int_t ev = First; ev < fNumEvents; ev += Step) {
+		fNoiseRND[First]->SetSeed (fNoiseSeeds[ev]); // The same noise as ElecChain of MakeWave seeded for event
+		fMakeWave->RenderWave (fPhotoElectrons[ev], fDarkElectrons[ev], fData + (size_t) ev * fStride, fNumSamples,
+		                       fNoiseRND[First], First);
+	}
+}
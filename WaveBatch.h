@@ -0,0 +1,91 @@
+#ifndef WaveBatch_H
+#define WaveBatch_H
+
+#include <vector>
+
+#include <Rtypes.h>
+#include <TRandom3.h>
+
+#include "PMT_R11410.hh"
+
+class MakeWave;
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Batch of events rendered together into one contiguous buffer of         //
+// MaxEvents rows of NumSamples samples (OutWave parameters of MakeWave).  //
+// Rows are aligned to 64 bytes, the buffer is allocated once and reused.  //
+//                                                                         //
+// Render() works in two passes over events of batch:                      //
+//   1) photons of all events are converted to SPE and dark counts are     //
+//      generated (sequentially: PMT owns one random generator)            //
+//   2) rows are rendered by MakeWave::RenderWave (the same SPE shape and  //
+//      electronics chain as for single events, so batch doesn't change    //
+//      waveforms); rows are independent and are shared between threads    //
+//      of MakeWave, each with its own copy of SPE shape                   //
+// Rendered batch is written by MakeWave::AddBatchToFile in one call.      //
+//                                                                         //
+// Cost of rendering of each event is the same as without batch (SPE are   //
+// stamped one by one with exact shape). Batch gains only from rendering   //
+// of rows of single-channel events in threads of MakeWave and from reuse  //
+// of buffers; with one thread it gives no speed-up.                       //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+class WaveBatch
+{
+	public:
+
+		WaveBatch (MakeWave *MakeWaveObj, Int_t MaxEvents);
+		~WaveBatch ();
+
+	// SETTERS
+		// Add photons of event (copied), return its index in batch (-1 if batch is full).
+		// PMTSeed - seed of PMT for this event, Seed - seed of MakeWave (see MakeWave::SetSeed)
+		// for electronics noise (0 - seed is taken from sequence of batch, see SetSeed)
+		Int_t AddEvent (const Double_t *Times, Int_t NumPhotons, UInt_t PMTSeed = 0, UInt_t Seed = 0);
+		Int_t AddEvent (const vector <double> &Times, UInt_t PMTSeed = 0, UInt_t Seed = 0) {
+			return AddEvent (Times.size() ? &Times[0] : 0, Times.size(), PMTSeed, Seed);
+		}
+		void Clear () {fNumEvents = 0;} // Remove all events (buffers are kept)
+		void SetSeed (UInt_t Seed) {fSeedRND.SetSeed (Seed);} // Sequence of noise seeds for events added without Seed
+
+	// GETTERS
+		Int_t  GetNumEvents ()  const {return fNumEvents;}
+		Int_t  GetMaxEvents ()  const {return fMaxEvents;}
+		Bool_t IsFull ()        const {return fNumEvents == fMaxEvents;}
+		Int_t  GetNumSamples () const {return fNumSamples;}
+		Int_t  GetStride ()     const {return fStride;}    // Distance between rows in samples
+		const Double_t* GetData () const {return fData;}   // Whole buffer
+		const Double_t* GetWave (Int_t ev) const {return fData + (size_t) ev * fStride;} // Waveform of event
+		Int_t GetNumPhotons (Int_t ev) const {return fTimes[ev].size();}
+		Int_t GetNumPE (Int_t ev)      const {return fPhotoElectrons[ev].size();}
+		const RED::PMT::PulseArray& GetPhotoElectrons (Int_t ev) const {return fPhotoElectrons[ev];}
+		const RED::PMT::PulseArray& GetDarkElectrons (Int_t ev)  const {return fDarkElectrons[ev];}
+
+	// ACTIONS
+		void Render (); // Create SPE and waveforms of all events
+
+	private:
+
+		void Allocate ();                        // Buffer for current OutWave parameters
+		void RenderRows (Int_t First, Int_t Step); // Stamp SPE of events First, First+Step, ... (one thread)
+
+		MakeWave *fMakeWave;
+		Int_t fMaxEvents;
+		Int_t fNumEvents;
+		Int_t fNumSamples;
+		Int_t fStride;
+		Double_t *fData;      // MaxEvents x Stride samples
+		vector <vector <double> > fTimes;             // Photon times of events
+		vector <UInt_t> fSeeds;                       // PMT seeds of events
+		vector <UInt_t> fNoiseSeeds;                  // Seeds of electronics noise of events
+		vector <RED::PMT::PulseArray> fPhotoElectrons; // SPE of events
+		vector <RED::PMT::PulseArray> fDarkElectrons;
+		vector <TRandom3*> fNoiseRND;                 // Generators for electronics noise (one per thread, reseeded for each event)
+		TRandom3 fSeedRND;                            // Noise seeds for events without Seed
+};
+
+#endif // WaveBatch_H
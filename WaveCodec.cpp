@@ -0,0 +1,187 @@
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "WaveCodec.h"
+
+static const UChar_t kMagic[4] = {'M','W','C','1'};
+static const Int_t kMinRun     = 4;  // Shorter runs of equal samples are coded inside blocks
+static const ULong64_t kSmall  = 16; // Zigzag values coded by 4 bits
+
+// Tokens
+enum {
+	kTokenRun     = 0,
+	kTokenBlock   = 1,
+	kTokenLiteral = 2
+};
+
+static inline ULong64_t ZigZag (Long64_t v) {
+	return ((ULong64_t) v << 1) ^ (ULong64_t) (v >> 63);
+}
+
+static inline Long64_t UnZigZag (ULong64_t z) {
+	return (Long64_t) (z >> 1) ^ -(Long64_t) (z & 1);
+}
+
+static inline void PutVarint (vector <UChar_t> &Coded, ULong64_t v) {
+	while (v >= 0x80) {
+		Coded.push_back ((v & 0x7F) | 0x80);
+		v >>= 7;
+	}
+	Coded.push_back (v);
+}
+
+// Read varint at pos, return false if stream is broken
+static inline Bool_t GetVarint (const UChar_t *Coded, size_t Size, size_t &pos, ULong64_t &v) {
+	v = 0;
+	for (Int_t shift = 0; shift < 64; shift += 7) {
+		if (pos >= Size)
+			return false;
+		UChar_t byte = Coded[pos++];
+		v |= (ULong64_t) (byte & 0x7F) << shift;
+		if (byte < 0x80)
+			return true;
+	}
+	return false;
+}
+
+size_t WaveCodec::Encode (const Double_t *Samples, Int_t NumSamples, vector <UChar_t> &Coded) {
+	Coded.assign (kMagic, kMagic + 4);
+	PutVarint (Coded, NumSamples);
+
+	// Zigzag differences of quantized samples
+	vector <ULong64_t> z (NumSamples);
+	Long64_t prev = 0;
+	for (Int_t i = 0; i < NumSamples; i++) {
+		Long64_t q = llround (Samples[i]);
+		z[i] = ZigZag (q - prev);
+		prev = q;
+	}
+
+	Int_t i = 0;
+	while (i < NumSamples) {
+		// Run of equal samples
+		Int_t run = 0;
+		while (i + run < NumSamples && z[i + run] == 0)
+			run++;
+		if (run >= kMinRun) {
+			PutVarint (Coded, ((ULong64_t) run << 2) | kTokenRun);
+			i += run;
+			continue;
+		}
+		// Large difference
+		if (z[i] >= kSmall) {
+			PutVarint (Coded, (z[i] << 2) | kTokenLiteral);
+			i++;
+			continue;
+		}
+		// Block of small differences until large one or long run
+		Int_t end = i;
+		while (end < NumSamples && z[end] < kSmall) {
+			if (z[end] == 0) {
+				Int_t zeros = 0;
+				while (end + zeros < NumSamples && zeros < kMinRun && z[end + zeros] == 0)
+					zeros++;
+				if (zeros >= kMinRun)
+					break;
+				end += zeros;
+			}
+			else
+				end++;
+		}
+		Int_t n = end - i;
+		PutVarint (Coded, ((ULong64_t) n << 2) | kTokenBlock);
+		for (Int_t k = 0; k < n; k += 2) {
+			UChar_t byte = z[i + k];
+			if (k + 1 < n)
+				byte |= z[i + k + 1] << 4;
+			Coded.push_back (byte);
+		}
+		i = end;
+	}
+	return Coded.size();
+}
+
+Int_t WaveCodec::GetNumSamples (const UChar_t *Coded, size_t Size) {
+	size_t pos = 4;
+	ULong64_t NumSamples;
+	if (Size < 4 || memcmp (Coded, kMagic, 4) || !GetVarint (Coded, Size, pos, NumSamples))
+		return -1;
+	return NumSamples;
+}
+
+Bool_t WaveCodec::Decode (const UChar_t *Coded, size_t Size, Double_t *Samples) {
+	size_t pos = 4;
+	ULong64_t NumSamples;
+	if (Size < 4 || memcmp (Coded, kMagic, 4) || !GetVarint (Coded, Size, pos, NumSamples))
+		return false;
+
+	Long64_t value = 0;
+	ULong64_t i = 0;
+	ULong64_t token;
+	while (i < NumSamples) {
+		if (!GetVarint (Coded, Size, pos, token))
+			return false;
+		ULong64_t n = token >> 2;
+		switch (token & 3) {
+			case kTokenRun:
+				if (i + n > NumSamples)
+					return false;
+				std::fill (Samples + i, Samples + i + n, (Double_t) value);
+				i += n;
+				break;
+			case kTokenBlock: {
+				if (i + n > NumSamples || pos + (n + 1)/2 > Size)
+					return false;
+				const UChar_t *bytes = Coded + pos;
+				for (ULong64_t k = 0; k < n; k++) {
+					value += UnZigZag ((bytes[k >> 1] >> ((k & 1) << 2)) & 0xF);
+					Samples[i + k] = value;
+				}
+				pos += (n + 1)/2;
+				i += n;
+				break;
+			}
+			case kTokenLiteral:
+				value += UnZigZag (n);
+				Samples[i++] = value;
+				break;
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+Bool_t WaveCodec::Decode (const UChar_t *Coded, size_t Size, vector <double> &Samples) {
+	Int_t NumSamples = GetNumSamples (Coded, Size);
+	if (NumSamples < 0)
+		return false;
+	Samples.resize (NumSamples);
+	return Decode (Coded, Size, &Samples[0]);
+}
+
+// Blob: number of bytes, then bytes of coded stream
+void WaveCodec::Pack (const vector <double> &Samples, vector <double> &Blob) {
+	Pack (Samples.size() ? &Samples[0] : 0, Samples.size(), Blob);
+}
+
+void WaveCodec::Pack (const Double_t *Samples, Int_t NumSamples, vector <double> &Blob) {
+	static thread_local vector <UChar_t> Coded;
+	size_t Size = Encode (Samples, NumSamples, Coded);
+	Blob.assign (1 + (Size + sizeof(double) - 1)/sizeof(double), 0);
+	Blob[0] = Size;
+	memcpy (&Blob[1], &Coded[0], Size);
+}
+
+Bool_t WaveCodec::IsPacked (const vector <double> &Blob, Int_t NumSamples) {
+	if (Blob.size() < 2 || Blob[0] < 4 || Blob[0] > (Blob.size() - 1) * sizeof(double))
+		return false;
+	return GetNumSamples ((const UChar_t*) &Blob[1], Blob[0]) == NumSamples;
+}
+
+Bool_t WaveCodec::Unpack (const vector <double> &Blob, vector <double> &Samples) {
+	if (Blob.size() < 2 || Blob[0] > (Blob.size() - 1) * sizeof(double))
+		return false;
+	return Decode ((const UChar_t*) &Blob[1], Blob[0], Samples);
+}
@@ -0,0 +1,52 @@
+#ifndef WaveCodec_H
+#define WaveCodec_H
+
+#include <vector>
+
+#include <Rtypes.h>
+
+/////////////////////////////////////////////////////////////////////////////
+//                                                                         //
+// Quantizing codec for digitized waveforms (mostly baseline with sparse   //
+// SPE pulses). Samples are rounded to integer ADC counts: step is 1 ADC   //
+// count (fGain of MakeWave), error is up to 0.5 count. Codec is lossless  //
+// only for integer samples (real digitizer, ElecChain with AddRound).     //
+//                                                                         //
+// Coding steps: difference of neighbouring samples -> zigzag (signed to   //
+// unsigned) -> tokens, each token is a varint (7 bits per byte):          //
+//   (n << 2) | 0 - run of n samples equal to previous one (baseline)      //
+//   (n << 2) | 1 - block of n small differences, followed by n/2 bytes    //
+//                  with 4-bit zigzag values                               //
+//   (z << 2) | 2 - one difference with zigzag value z                     //
+// Stream starts with magic "MWC1" and varint number of samples.           //
+// All codes are byte aligned, so decoder has no bit reading and runs of   //
+// baseline are decoded as a plain fill.                                   //
+//                                                                         //
+// Coded waveform can be stored in REDFile as fData of RED::Waveform       //
+// (Pack/Unpack, fNumSamples keeps real number of samples) or in flat      //
+// file with sample type kFlatCodec.                                       //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+using std::vector;
+
+class WaveCodec
+{
+	public:
+
+		// Encode samples to byte stream Coded (previous content is replaced), return its size
+		static size_t Encode (const Double_t *Samples, Int_t NumSamples, vector <UChar_t> &Coded);
+		// Number of samples in coded stream (-1 if stream is not valid)
+		static Int_t GetNumSamples (const UChar_t *Coded, size_t Size);
+		// Decode stream to Samples (array of GetNumSamples() values)
+		static Bool_t Decode (const UChar_t *Coded, size_t Size, Double_t *Samples);
+		static Bool_t Decode (const UChar_t *Coded, size_t Size, vector <double> &Samples);
+
+		// Coded waveform in array of doubles (for fData of RED::Waveform)
+		static void Pack (const vector <double> &Samples, vector <double> &Blob);
+		static void Pack (const Double_t *Samples, Int_t NumSamples, vector <double> &Blob);
+		static Bool_t IsPacked (const vector <double> &Blob, Int_t NumSamples); // NumSamples - real number of samples of waveform
+		static Bool_t Unpack (const vector <double> &Blob, vector <double> &Samples);
+};
+
+#endif // WaveCodec_H
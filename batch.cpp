@@ -0,0 +1,164 @@
+#include <iostream>
+#include <cstdlib>
+
+#include <Rtypes.h>
+#include <TFile.h>
+#include <TH2F.h>
+
+#include <REDFile/File.hh>
+#include <REDEvent/Event.hh>
+
+#include "MakeWave.h"
+#include "PMT_R11410.hh"
+#include "SimPhotons.h"
+#include "RunConfig.h"
+#include "WaveBatch.h"
+#include "EventIndex.h"
+#include "Hist2D.h"
+#include "CPUDispatch.h"
+
+using CLHEP::ns;
+using namespace std;
+
+// Batch runner: simulate events of one shard of run described by config file.
+// Usage: MakeWaveBatch config [Shard NumShards]
+// Shard outputs are combined by MakeWaveMerge
+int main (int argc, char **argv) {
+
+	if (argc != 2 && argc != 4) {
+		cout << "Usage: " << argv[0] << " config [Shard NumShards]" << endl;
+		return 1;
+	}
+	Int_t Shard     = 0;
+	Int_t NumShards = 1;
+	if (argc == 4) {
+		Shard     = atoi (argv[2]);
+		NumShards = atoi (argv[3]);
+		if (NumShards < 1 || Shard < 0 || Shard >= NumShards) {
+			cout << "ERROR. Wrong shard " << Shard << " of " << NumShards << endl;
+			return 1;
+		}
+	}
+
+	RunConfig Config;
+	if (!Config.ReadFile (argv[1]))
+		return 1;
+	Config.Print();
+	cout << "Kernels: " << GetKernelISA() << endl;
+
+	RED::PMT_R11410 *R11 = Config.CreatePMT();
+	MakeWave *MakeWaveObj = Config.CreateMakeWave (R11);
+	SimPhotons *Photons = Config.CreateSimPhotons();
+	if (Config.GetInt("PhotonWindow"))
+		Photons->SetWindow (MakeWaveObj);
+	Double_t FracTime = Config.GetDouble("FracTime")*ns;
+	WaveBatch *Batch = 0; // Events are rendered in batches (waveform output only)
+	if (Config.GetInt("BatchSize") > 1 && Config.WriteWaves())
+		Batch = new WaveBatch (MakeWaveObj, Config.GetInt("BatchSize"));
+
+	Long64_t First = 0;
+	Long64_t Last  = 0;
+	Config.GetShardRange (Shard, NumShards, First, Last);
+	cout << "Shard " << Shard << " of " << NumShards << ": events " << First << " .. " << Last - 1 << endl;
+
+	vector <string> Types = Config.GetTypes();
+	vector <TH2F*> Hists;
+	vector <Hist2D> FracHists; // Filled in event loop, added to Hists before writing
+	vector <Double_t> SimPhotonTimes;
+	EventIndexWriter Index;
+	EventIndexRecord Rec;
+	vector <Long64_t> Entries; // Entries of batch events in output files
+	for (unsigned int t = 0; t < Types.size(); t++) {
+		const char *type = Types[t].c_str();
+		TH2F *h_frac = new TH2F((string("frac") + type).c_str(),"",2001,0,2000,101,0,1.01);
+		h_frac->SetDirectory(0);
+		h_frac->SetXTitle("Photoelectrons number");
+		h_frac->SetYTitle("F90");
+		Hists.push_back (h_frac);
+		FracHists.push_back (Hist2D (2001,0,2000,101,0,1.01));
+
+		string OutName = Config.GetOutName (type);
+		if (NumShards > 1)
+			OutName = RunConfig::GetShardName (OutName, Shard, NumShards);
+		if (Config.WriteWaves() && !MakeWaveObj->GetNewFile (OutName.c_str()))
+			return 1;
+		if (Config.WritePulses() && !MakeWaveObj->GetNewPulseFile (RunConfig::GetPulseName(OutName).c_str(), Config.ToString().c_str()))
+			return 1;
+		// Seeds only: events are regenerated from config and index by RunRegenerator
+		if (Config.WriteSeedsOnly() && !Config.WriteFile ((OutName + ".cfg").c_str()))
+			return 1;
+		if ((Config.GetInt("Index") || Config.WriteSeedsOnly()) && !Index.Open (EventIndexWriter::GetIndexName(OutName).c_str(), FracTime,
+		                                         Photons->GetWindowBegin(), Photons->GetWindowEnd()))
+			return 1;
+		for (Long64_t ev = First; ev < Last; ev++) {
+			Int_t NumPhotons = Config.GetNumPhotons (ev);
+			if (!((ev - First) % 100))
+				cout << type << " event " << ev << " (" << NumPhotons << " photons)" << endl;
+			RunConfig::SetEventSeed (Config.GetEventSeed (t, ev), Photons, R11, MakeWaveObj);
+			SimPhotonTimes = Photons->SimulatePhotons (NumPhotons, type);
+			if (Batch) {
+				Batch->AddEvent (SimPhotonTimes, RunConfig::GetPMTSeed (Config.GetEventSeed (t, ev)),
+				                 RunConfig::GetMakeWaveSeed (Config.GetEventSeed (t, ev)));
+				if (!Batch->IsFull() && ev < Last - 1)
+					continue;
+				Batch->Render();
+				MakeWaveObj->AddBatchToFile (*Batch, &Entries);
+				Long64_t FirstEv = ev - Batch->GetNumEvents() + 1;
+				for (Int_t b = 0; b < Batch->GetNumEvents(); b++) {
+					Double_t Frac = MakeWaveObj->GetFrac (Batch->GetPhotoElectrons (b), FracTime);
+					if (Frac)
+						FracHists[t].Fill (Batch->GetNumPE (b), Frac);
+					if (Index.IsOpen()) {
+						Rec.fEntry      = Entries[b];
+						Rec.fEventID    = FirstEv + b;
+						Rec.fSeed       = Config.GetEventSeed (t, FirstEv + b);
+						Rec.fNumPhotons = Config.GetNumPhotons (FirstEv + b); // Requested, as without batch
+						Rec.fNumPE      = Batch->GetNumPE (b);
+						Rec.fF90        = Frac;
+						Index.AddEvent (Rec);
+					}
+				}
+				Batch->Clear();
+				continue;
+			}
+			MakeWaveObj->SetPhotonTimes (&SimPhotonTimes);
+			if (Config.WriteWaves())
+				MakeWaveObj->CreateOutWave();
+			else
+				MakeWaveObj->CreatePulses(); // Waveform will be rendered later from pulse file (or regenerated)
+			if (!Config.WriteSeedsOnly())
+				MakeWaveObj->AddToFile();
+			Double_t Frac = MakeWaveObj->GetFrac (FracTime);
+			if (Frac)
+				FracHists[t].Fill (MakeWaveObj->GetNumPE(), Frac);
+			if (Index.IsOpen()) {
+				Rec.fEntry      = Config.WriteSeedsOnly() ? (Long64_t) EventIndexRecord::kNotWritten : MakeWaveObj->GetLastEntry();
+				Rec.fEventID    = ev;
+				Rec.fSeed       = Config.GetEventSeed (t, ev);
+				Rec.fNumPhotons = NumPhotons;
+				Rec.fNumPE      = MakeWaveObj->GetNumPE();
+				Rec.fF90        = Frac;
+				Index.AddEvent (Rec);
+			}
+		}
+		Index.Close();
+		MakeWaveObj->CloseFile();
+		MakeWaveObj->ClosePulseFile();
+	}
+
+	// Save histograms
+	string HistName = Config.GetHistName();
+	if (NumShards > 1)
+		HistName = RunConfig::GetShardName (HistName, Shard, NumShards);
+	TFile *HistFile = new TFile (HistName.c_str(), "RECREATE");
+	for (unsigned int t = 0; t < Hists.size(); t++) {
+		FracHists[t].AddTo (Hists[t]);
+		Hists[t]->Write();
+	}
+	HistFile->Close();
+
+	if (Photons->GetTotalSkipped())
+		cout << Photons->GetTotalSkipped() << " of " << Photons->GetTotalPhotons() << " photons were outside of window and skipped" << endl;
+	cout << "well done" << endl;
+	return 0;
+}
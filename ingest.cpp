@@ -0,0 +1,53 @@
+#include <iostream>
+
+#include <Rtypes.h>
+
+#include "PMT_R11410.hh"
+#include "MakeWave.h"
+#include "PhotonFile.h"
+#include "RunConfig.h"
+#include "CPUDispatch.h"
+
+using CLHEP::ns;
+using namespace std;
+
+// Render waveforms of events from external photon file (see PhotonFile.h)
+// into REDFile. PMT and OutWave parameters are taken from config file.
+// Photon times are passed to MakeWave directly from mapped file.
+// Usage: MakeWaveIngest config photons.dat out.root
+int main (int argc, char **argv) {
+
+	if (argc != 4) {
+		cout << "Usage: " << argv[0] << " config photons.dat out.root" << endl;
+		return 1;
+	}
+	RunConfig Config;
+	if (!Config.ReadFile (argv[1]))
+		return 1;
+	Config.Print();
+	cout << "Kernels: " << GetKernelISA() << endl;
+
+	PhotonFileReader Reader;
+	if (!Reader.Open (argv[2]))
+		return 1;
+	cout << Reader.GetNumEvents() << " events, " << Reader.GetNumPhotons() << " photons in " << argv[2] << endl;
+
+	RED::PMT_R11410 *R11 = Config.CreatePMT();
+	MakeWave *MakeWaveObj = Config.CreateMakeWave (R11);
+	if (!MakeWaveObj->GetNewFile (argv[3]))
+		return 1;
+	PhotonSpan Span;
+	for (Long64_t ev = 0; ev < Reader.GetNumEvents(); ev++) {
+		if (!(ev % 100))
+			cout << "event " << ev << " (" << Reader.GetNumPhotons (ev) << " photons)" << endl;
+		if (!Reader.GetEvent (ev, Span))
+			return 1;
+		RunConfig::SetEventSeed (Config.GetEventSeed (0, ev), 0, R11, MakeWaveObj); // Photons are given, PMT and MakeWave as in batch
+		MakeWaveObj->SetPhotonTimes (Span.fTimes, Span.fNumPhotons, Span.fChannels);
+		MakeWaveObj->CreateOutWave();
+		MakeWaveObj->AddToFile();
+	}
+	MakeWaveObj->CloseFile();
+	cout << "well done" << endl;
+	return 0;
+}
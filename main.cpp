@@ -19,6 +19,9 @@
 #include "PMT_R11410.hh"
 #include "SimPhotons.h"
 #include "MakeTest.h"
+#include "Pipeline.h"
+#include "Hist2D.h"
+#include "CPUDispatch.h"
 
 using CLHEP::mV;
 using CLHEP::ns;
@@ -149,6 +152,7 @@ int main () {
 // CREATE OUTWAVE
 	
 	// Set OutWave parameters
+	cout << "Kernels: " << GetKernelISA() << endl;
 	MakeWave *MakeWaveObj = new MakeWave(); // Create object of MakeWave class
 	MakeWaveObj->SetPMT (R11);            // Set used PMT
 	Double_t Period     = 4*ns;
@@ -159,52 +163,45 @@ int main () {
 
 	SimPhotons *Photons = new SimPhotons();
 	Photons->SetDefFastFract();
-	vector <Double_t> SimPhotonTimes;
 	OutputFile *outfile;
 
-	TH2F *h_fracER = new TH2F("fracER","",2001,0,2000,101,0,1.01);
-	h_fracER->SetMarkerStyle(7);
-	h_fracER->SetMarkerColor(4);
-	TH2F *h_fracNR = new TH2F("fracNR","",2001,0,2000,101,0,1.01);
-	h_fracNR->SetMarkerStyle(7);
-	h_fracNR->SetMarkerColor(2);
+	Hist2D FracER (2001,0,2000,101,0,1.01); // Output stages add their histograms at the end of run, converted to TH2F for drawing
+	Hist2D FracNR (2001,0,2000,101,0,1.01);
 	Double_t FracTime = 90*ns;
-	Double_t Frac = 0;
 
 	TApplication *app = new TApplication("canvas",0,0);
 
-	char name[128];
+	// Events are simulated in pipeline: photons -> PMT -> waveform -> file
+	Int_t MinPhotons = 100;
+	Int_t MaxPhotons = 4000;
 
 	outfile = MakeWaveObj->GetNewFile("ER.root");
-	for (Int_t NumPhotons = 100; NumPhotons < 4000; NumPhotons += 1) {
-		cout << "ER " << NumPhotons << " photons" << endl;
-		SimPhotonTimes = Photons->SimulatePhotons(NumPhotons, "ER");
-		MakeWaveObj->SetPhotonTimes (&SimPhotonTimes);
-		MakeWaveObj->CreateOutWave();
-		MakeWaveObj->AddToFile();
-		Frac = MakeWaveObj->GetFrac(FracTime);
-		if (Frac)
-			h_fracER->Fill(MakeWaveObj->GetNumPE(), Frac);
-		//sprintf(name, "ER_wf_%d.root", NumPhotons);
-		//MakeWaveObj->SaveOutWave(name);
-	}
+	Pipeline PipeER; // Owns its stages
+	PipeER.AddStage (new SimStage (Photons, "ER", MinPhotons));
+	PipeER.AddStage (new PMTStage (MakeWaveObj));
+	PipeER.AddStage (new RenderStage (MakeWaveObj));
+	PipeER.AddStage (new OutStage (MakeWaveObj, &FracER, FracTime));
+	PipeER.Run (MaxPhotons - MinPhotons);
+	PipeER.PrintStats();
 	MakeWaveObj->CloseFile();
 
 	outfile = MakeWaveObj->GetNewFile("NR.root");
-	for (Int_t NumPhotons = 100; NumPhotons < 4000; NumPhotons += 1) {
-		cout << "NR " << NumPhotons << " photons" << endl;
-		SimPhotonTimes = Photons->SimulatePhotons(NumPhotons, "NR");
-		MakeWaveObj->SetPhotonTimes (&SimPhotonTimes);
-		MakeWaveObj->CreateOutWave();
-		MakeWaveObj->AddToFile();
-		Frac = MakeWaveObj->GetFrac(FracTime);
-		if (Frac)
-			h_fracNR->Fill(MakeWaveObj->GetNumPE(), Frac);
-		//sprintf(name, "ER_wf_%d.root", NumPhotons);
-		//MakeWaveObj->SaveOutWave(name);
-	}
+	Pipeline PipeNR; // Owns its stages
+	PipeNR.AddStage (new SimStage (Photons, "NR", MinPhotons));
+	PipeNR.AddStage (new PMTStage (MakeWaveObj));
+	PipeNR.AddStage (new RenderStage (MakeWaveObj));
+	PipeNR.AddStage (new OutStage (MakeWaveObj, &FracNR, FracTime));
+	PipeNR.Run (MaxPhotons - MinPhotons);
+	PipeNR.PrintStats();
 	MakeWaveObj->CloseFile();
 
+	TH2F *h_fracER = FracER.ToTH2F ("fracER");
+	h_fracER->SetMarkerStyle(7);
+	h_fracER->SetMarkerColor(4);
+	TH2F *h_fracNR = FracNR.ToTH2F ("fracNR");
+	h_fracNR->SetMarkerStyle(7);
+	h_fracNR->SetMarkerColor(2);
+
 	TCanvas *c = new TCanvas("c1","",800,600);
 	h_fracER->Draw();
 	h_fracNR->Draw("SAME");
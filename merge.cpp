@@ -0,0 +1,61 @@
+#include <iostream>
+#include <cstdlib>
+
+#include <Rtypes.h>
+#include <TFileMerger.h>
+
+#include "RunConfig.h"
+
+using namespace std;
+
+// Merge shard outputs of MakeWaveBatch into files of the whole run.
+// Trees are merged by fast cloning (compressed baskets are copied without
+// reading waveforms), histograms of shards are added.
+// Usage: MakeWaveMerge config NumShards
+static Bool_t MergeShards (const string &name, Int_t NumShards) {
+	TFileMerger Merger (kFALSE);
+	Merger.SetFastMethod (kTRUE);
+	if (!Merger.OutputFile (name.c_str(), "RECREATE"))
+		return false;
+	for (Int_t Shard = 0; Shard < NumShards; Shard++) {
+		string ShardName = RunConfig::GetShardName (name, Shard, NumShards);
+		if (!Merger.AddFile (ShardName.c_str())) {
+			cout << "ERROR. Shard file " << ShardName << " can't be added" << endl;
+			return false;
+		}
+	}
+	if (!Merger.Merge()) {
+		cout << "ERROR. Shards of " << name << " were not merged" << endl;
+		return false;
+	}
+	cout << NumShards << " shards were merged into " << name << endl;
+	return true;
+}
+
+int main (int argc, char **argv) {
+
+	if (argc != 3) {
+		cout << "Usage: " << argv[0] << " config NumShards" << endl;
+		return 1;
+	}
+	RunConfig Config;
+	if (!Config.ReadFile (argv[1]))
+		return 1;
+	Int_t NumShards = atoi (argv[2]);
+	if (NumShards < 1) {
+		cout << "ERROR. Wrong number of shards " << NumShards << endl;
+		return 1;
+	}
+
+	vector <string> Types = Config.GetTypes();
+	for (unsigned int t = 0; t < Types.size(); t++) {
+		string OutName = Config.GetOutName (Types[t].c_str());
+		if (Config.WriteWaves() && !MergeShards (OutName, NumShards))
+			return 1;
+		if (Config.WritePulses() && !MergeShards (RunConfig::GetPulseName (OutName), NumShards))
+			return 1;
+	}
+	if (!MergeShards (Config.GetHistName(), NumShards))
+		return 1;
+	return 0;
+}
@@ -0,0 +1,38 @@
+#include <iostream>
+#include <cstdlib>
+
+#include <Rtypes.h>
+
+#include <REDFile/File.hh>
+#include <REDEvent/Event.hh>
+
+#include "RunRegenerator.h"
+
+using namespace std;
+
+// Regenerate events of run from its config (e.g. ER.root.cfg of OutputMode = seeds) into REDFile.
+// Usage: MakeWaveRegen config type out.root EventID [EventID ...]
+int main (int argc, char **argv) {
+
+	if (argc < 5) {
+		cout << "Usage: " << argv[0] << " config type out.root EventID [EventID ...]" << endl;
+		return 1;
+	}
+	RunConfig Config;
+	if (!Config.ReadFile (argv[1]))
+		return 1;
+	RunRegenerator Regenerator (Config);
+	MakeWave *MakeWaveObj = Regenerator.GetMakeWave();
+	if (!MakeWaveObj->GetNewFile (argv[3]))
+		return 1;
+	for (Int_t i = 4; i < argc; i++) {
+		Long64_t ev = atoll (argv[i]);
+		if (!Regenerator.RegenerateEvent (argv[2], ev))
+			return 1;
+		cout << argv[2] << " event " << ev << ": " << Regenerator.GetPhotonTimes().size() << " photons, "
+		     << Regenerator.GetNumPE() << " photoelectrons" << endl;
+		MakeWaveObj->AddToFile();
+	}
+	MakeWaveObj->CloseFile();
+	return 0;
+}
@@ -0,0 +1,45 @@
+#include <iostream>
+#include <cstdlib>
+
+#include <Rtypes.h>
+
+#include <REDFile/File.hh>
+#include <REDEvent/Event.hh>
+
+#include "MakeWave.h"
+#include "PulseFile.h"
+
+using CLHEP::ns;
+using CLHEP::mV;
+using namespace std;
+
+// Render waveforms from truth-level pulse file into REDFile.
+// OutWave parameters of the run can be replaced by new ones.
+// Usage: MakeWaveRender pulses.root out.root [Period(ns) Gain(mV) NumSamples Delay(ns)]
+int main (int argc, char **argv) {
+
+	if (argc != 3 && argc != 7) {
+		cout << "Usage: " << argv[0] << " pulses.root out.root [Period(ns) Gain(mV) NumSamples Delay(ns)]" << endl;
+		return 1;
+	}
+	PulseReader Reader;
+	if (!Reader.Open (argv[1]))
+		return 1;
+	MakeWave *MakeWaveObj = Reader.CreateMakeWave();
+	if (!MakeWaveObj)
+		return 1;
+	if (argc == 7)
+		MakeWaveObj->SetOutWave (atof(argv[3])*ns, atof(argv[4])*mV, atoi(argv[5]), atof(argv[6])*ns);
+
+	if (!MakeWaveObj->GetNewFile (argv[2]))
+		return 1;
+	vector <double> OutWave;
+	for (Long64_t ev = 0; ev < Reader.GetNumEvents(); ev++) {
+		if (!Reader.RenderEvent (ev, MakeWaveObj, OutWave))
+			return 1;
+		MakeWaveObj->AddToFile (OutWave);
+	}
+	MakeWaveObj->CloseFile();
+	cout << Reader.GetNumEvents() << " events were rendered into " << argv[2] << endl;
+	return 0;
+}
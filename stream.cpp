@@ -0,0 +1,58 @@
+#include <iostream>
+#include <chrono>
+
+#include <Rtypes.h>
+
+#include "PMT_R11410.hh"
+#include "SimPhotons.h"
+#include "StreamWave.h"
+#include "FlatWaveFile.h"
+#include "RunConfig.h"
+#include "CPUDispatch.h"
+
+using CLHEP::ns;
+using namespace std;
+
+// Continuous digitizer stream with Poisson events described by config file.
+// Chunks are written to flat waveform file "Output_Stream".
+// Usage: MakeWaveStream config
+int main (int argc, char **argv) {
+
+	if (argc != 2) {
+		cout << "Usage: " << argv[0] << " config" << endl;
+		return 1;
+	}
+	RunConfig Config;
+	if (!Config.ReadFile (argv[1]))
+		return 1;
+	Config.Print();
+	cout << "Kernels: " << GetKernelISA() << endl;
+
+	RED::PMT_R11410 *R11 = Config.CreatePMT();
+	SimPhotons *Photons = Config.CreateSimPhotons();
+	Double_t Period = Config.GetDouble("Period")*ns;
+	Double_t Gain   = Config.GetDouble("Gain")*mV;
+
+	FlatWaveWriter Writer;
+	if (!Writer.Open (Config.GetString("Output_Stream").c_str()))
+		return 1;
+	FlatStreamSink Sink (&Writer, Period, Gain);
+
+	StreamWave Stream (R11, Photons);
+	Stream.SetOutWave (Period, Gain, Config.GetInt("Stream_ChunkSize"));
+	Stream.SetEvents (Config.GetString("Stream_Type").c_str(), Config.GetInt("MinPhotons"), Config.GetInt("MaxPhotons"));
+	Stream.SetSeed (Config.GetInt("Seed"));
+	Stream.SetRate (Config.GetDouble("Stream_Rate")/(1e9*ns));
+	Stream.SetSink (&Sink);
+
+	auto Start = chrono::steady_clock::now();
+	Stream.Run (Config.GetDouble("Stream_Duration")*ns);
+	Double_t Elapsed = chrono::duration <double> (chrono::steady_clock::now() - Start).count();
+	Writer.Close();
+
+	cout << Stream.GetNumChunks() << " chunks (" << Stream.GetTime()/ns << " ns), "
+	     << Stream.GetNumEvents() << " events, " << Stream.GetNumPulses() << " SPE" << endl;
+	cout << "Maximum pending SPE: " << Stream.GetMaxPending() << endl;
+	cout << "Generated in " << Elapsed << " s (" << Stream.GetTime()/ns*1e-9/Elapsed << " x real time)" << endl;
+	return 0;
+}